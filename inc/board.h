@@ -0,0 +1,71 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "../inc/field.h"
+
+using namespace std;
+
+constexpr int kMaxBoxes = 14;  // ящики 'A'..'N', цели 'a'..'n'
+
+using Cell = uint16_t;
+
+constexpr Cell kNoCell = 0xFFFF;
+
+// Компактное состояние для решателя: клетка каждого ящика по его букве + клетка игрока.
+// Ящики в этой игре именные ('A' должен встать на 'a'), поэтому вместо битовой маски
+// храним позицию каждой буквы — это те же 30 байт без единой аллокации.
+struct BoardState {
+    array<Cell, kMaxBoxes> boxes;
+    Cell player;
+
+    bool operator==(const BoardState& other) const {
+        return player == other.player && boxes == other.boxes;
+    }
+};
+
+constexpr uint32_t kZobristPlayer = kMaxBoxes;   // слот игрока
+constexpr uint32_t kZobristBox = kMaxBoxes + 1;  // слот безымянного ящика (генератор)
+
+// Zobrist-ключ для (слот, клетка): буква ящика/игрок/ящик генератора в конкретной клетке.
+// Случайное число берём из splitmix64 прямо по индексу, а не из таблицы: значения те же
+// по смыслу, но нет ни памяти под таблицу, ни ограничения на размер поля.
+inline uint64_t ZobristKey(uint32_t slot, uint32_t cell) {
+    uint64_t z = (uint64_t(slot) << 32 | cell) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+inline uint32_t ZobristCell(Point p) {
+    return uint32_t(p.y) << 16 | uint16_t(p.x);
+}
+
+// Неизменяемая часть уровня: стены и цели, строится один раз из GameDescriptor::emptyField.
+// Поле окружено рамкой из стен, поэтому соседи клетки — это просто c ± 1 и c ± stride.
+class Board {
+   private:
+    int width;
+    int height;
+    int stride;
+    vector<uint8_t> floor;         // 1 — по клетке можно ходить
+    array<Cell, kMaxBoxes> goals;  // клетка цели для каждой буквы или kNoCell
+    array<int, 4> offsets;         // сдвиги клетки для LEFT, RIGHT, UP, DOWN
+
+   public:
+    Board(Field& emptyField);
+    BoardState MakeState(Field& f) const;
+    bool TryMove(BoardState& s, Directions d, uint64_t& key) const;
+    uint64_t Hash(const BoardState& s) const;
+    bool IsSolved(const BoardState& s) const;
+    int BoxAt(const BoardState& s, Cell c) const;
+    Cell ToCell(Point p) const { return Cell((p.y + 1) * stride + p.x + 1); }
+    Point ToPoint(Cell c) const { return {c % stride - 1, c / stride - 1}; }
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+};
+
+#endif
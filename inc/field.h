@@ -8,7 +8,9 @@
 #include <memory>
 #include <optional>
 #include <queue>
+#include <random>
 #include <set>
+#include <utility>
 #include <vector>
 using namespace std;
 
@@ -76,6 +78,49 @@ struct hash<Point> {
 };
 }  // namespace std
 
+// Плотная карта генератора: тип блока в каждой клетке [y * width + x], EMPTY — свободно.
+// Рядом хранятся якоря (GetRandomAnchor выбирает по номеру за O(1)) и список свободных
+// клеток с обратным индексом: случайная свободная клетка находится и занимается за O(1).
+class MapGrid {
+   private:
+    int height = 0;
+    int width = 0;
+    vector<BlockType> cells;  // BlockType — uint8_t, так что это тот же vector<uint8_t>
+    vector<Point> anchors;
+    vector<int> freeCells;  // индексы свободных клеток в произвольном порядке
+    vector<int> freeSlot;   // [клетка] — позиция в freeCells или -1
+
+    void SwapFree(int i, int j);
+
+   public:
+    MapGrid() = default;
+    MapGrid(int mapHeight, int mapWidth);
+
+    bool Contains(Point p) const { return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height; }
+    // вне карты — EMPTY, как у отсутствующего ключа в прежнем unordered_map
+    BlockType At(Point p) const { return Contains(p) ? cells[p.y * width + p.x] : BlockType::EMPTY; }
+    void Set(Point p, BlockType t);
+
+    int GetHeight() const { return height; }
+    int GetWidth() const { return width; }
+    const vector<Point>& GetAnchors() const { return anchors; }
+    size_t FreeCount() const { return freeCells.size(); }
+
+    // Случайная свободная клетка, для которой ok(p) — true. Частичное перемешивание
+    // freeCells: каждая клетка проверяется не больше одного раза, без бесконечных повторов.
+    template <typename Pred>
+    optional<Point> RandomFree(mt19937& rng, Pred ok) {
+        for (size_t k = 0; k < freeCells.size(); k++) {
+            size_t j = uniform_int_distribution<size_t>(k, freeCells.size() - 1)(rng);
+            SwapFree(int(k), int(j));
+            Point p{freeCells[k] % width, freeCells[k] / width};
+            if (ok(p))
+                return p;
+        }
+        return nullopt;
+    }
+};
+
 struct BoxPlace {
     char name;
     Point pos;
@@ -85,6 +130,8 @@ class GameDescriptor;
 
 struct StepAnim;
 
+constexpr uint8_t kPushedFlag = 4;  // в записи журнала Field: ход толкнул ящик
+
 class Field {
    private:
     /* data */
@@ -93,11 +140,23 @@ class Field {
     char* arr;
     std::shared_ptr<GameDescriptor> game;
     unordered_map<Point, BlockType> placedBlocks;
+    vector<Point> dirty;  // клетки, изменённые Move с прошлого TakeDirty
+    // Обновляются в Move за O(1); заново считаются только при загрузке карты и в SetGame
+    Point player{-1, -1};  // {-1, -1} — на карте нет игрока
+    int boxesOnGoal = 0;   // ящиков на целях со своей буквой (известно после SetGame)
+    // Журнал ходов: байт на ход — направление в младших двух битах и kPushedFlag, если ход
+    // толкнул ящик. history[0..historyPos) сделаны, остальное — то, что можно вернуть Redo.
+    vector<uint8_t> history;
+    size_t historyPos = 0;
+
+    void FindPlayer();
+    void Apply(Directions d, StepAnim& anim);
 
    public:
     // static Point GetDirectionVector(Directions d);
     Field(std::string fileName);
     Field(std::stringstream& ss);
+    Field(int height, int width);  // пустое поле (одни пробелы) — его заполняют через GetCell
     Field(const Field& other);
     Field(Field&& Other) noexcept;
     Field& operator=(const Field& other);
@@ -108,12 +167,15 @@ class Field {
     bool HaveWon(const GameDescriptor& g);
     bool CanMove(Directions d);
     bool Move(Directions d, StepAnim& anim);
+    bool Undo();
+    bool Redo(StepAnim& anim);
+    void Restart();
     bool IsEmptySpace(Point p);
     bool IsBox(Point p);
     bool IsBoxPlaced(Point p);
-    static bool IsInRestrictedRadius(WallBlock& block, unordered_map<Point, BlockType>& placedBlocks, Point& random_dir, WallCluster& wall);
-    static bool IsMiddleBlockAcceptable(WallBlock& block, unordered_map<Point, BlockType>& placedBlocks, Point& random_dir, WallCluster& wall);
-    static bool WallCorrect(WallCluster& wall, unordered_map<Point, BlockType>& placedBlocks, Point& random_dir);
+    static bool IsInRestrictedRadius(WallBlock& block, MapGrid& placedBlocks, Point& random_dir, WallCluster& wall);
+    static bool IsMiddleBlockAcceptable(WallBlock& block, MapGrid& placedBlocks, Point& random_dir, WallCluster& wall);
+    static bool WallCorrect(WallCluster& wall, MapGrid& placedBlocks, Point& random_dir);
 
     void Clear();
     // getter & setter
@@ -122,21 +184,22 @@ class Field {
     Point GetLoaderPosition();
     static array<Point, 5> GetNeighborPointsArray(WallBlock& block, Point& random_dir);
     static array<Point, 8> GetEightDirections();
-    static WallBlock GetRandomAnchor(int SelectedAnchor, unordered_map<Point, BlockType>& placedBlocks);
+    static WallBlock GetRandomAnchor(int SelectedAnchor, MapGrid& placedBlocks);
     int GetHeight() { return height; }
     int GetWidth() { return width; }
     char GetBackgroundAt(Point p) const;
 
     void SetGame(std::shared_ptr<GameDescriptor> g);
     string ToString() const;
+    vector<Point> TakeDirty() { return std::exchange(dirty, {}); }
     void LoadFromGenerator(std::stringstream& ss);
 
-    static unordered_map<Point, BlockType> InitMap(int& mapHeight, int& mapWidth, int& anchorCounter);
+    static MapGrid InitMap(int& mapHeight, int& mapWidth, int& anchorCounter);
     // adders
-    static void AddToPlacedBlocks(WallCluster wall, unordered_map<Point, BlockType>& placedBlocks);
-    static vector<Point> AddBoxes(unordered_map<Point, BlockType>& placedBlocks, int& mapHeight, int& mapWidth);
-    static Point AddPlayer(unordered_map<Point, BlockType>& placedBlocks, int& mapHeight, int& mapWidth);
-    static vector<Point> AddTarget(unordered_map<Point, BlockType>& placedBlocks, int& mapHeight, int& mapWidt, int& targets);
+    static void AddToPlacedBlocks(WallCluster wall, MapGrid& placedBlocks);
+    static vector<Point> AddBoxes(MapGrid& placedBlocks, int& mapHeight, int& mapWidth, int& boxes, mt19937& rng);
+    static Point AddPlayer(MapGrid& placedBlocks, int& mapHeight, int& mapWidth, mt19937& rng);
+    static vector<Point> AddTarget(MapGrid& placedBlocks, int& mapHeight, int& mapWidt, int& targets, mt19937& rng);
 };
 
 void ReloadMap(Field& f, const std::string& fileName);
@@ -146,6 +209,7 @@ void GenerateNewMap(Field& f, std::stringstream& ss);
 class GameDescriptor {
    public:
     Field emptyField;
+    Field startField;  // уровень в начальном положении — с него Restart
     std::vector<BoxPlace> boxPlaces;
     GameDescriptor(Field& field);
 };
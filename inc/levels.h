@@ -0,0 +1,32 @@
+#ifndef LEVELS_H
+#define LEVELS_H
+
+#include <istream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../inc/prog.h"
+
+// Уровень из сборника: стены и ящики в start.map (как у поиска генератора — без игрока и целей),
+// игрок, цели и ящики — в start.reverseMap. Ящик или игрок на цели записываются и туда, и туда.
+// Буквы ящиков и целей формата игры — в start.reverseMap.boxLetters и targetLetters.
+struct ParsedLevel {
+    std::string title;  // последняя строка-комментарий перед картой (может быть пустой)
+    int height;
+    int width;
+    StateForGenerator start;
+};
+
+// Читает все уровни из текста. Понимает символы XSB (# $ . @ * + и пол ' ', '-', '_')
+// и формат игры (o, x, A-N, a-n).
+// Строки заголовков ("14 14", "level ...", "; 1", "Title: ...") картой не считаются.
+std::vector<ParsedLevel> ReadLevelCollection(std::istream& in);
+
+// Разворачивает решение по толчкам в ходы LURD: строчная буква — шаг, заглавная — толчок.
+// Какой ящик толкать, если подходят несколько, выбирается перебором с возвратом. У уровня
+// с буквами решение засчитывается, только если каждая цель с буквой занята ящиком той же
+// буквы; nullopt — толчки так не доигрываются.
+std::optional<std::string> PushesToLurd(const ParsedLevel& level, const std::vector<Directions>& pushes);
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../inc/levels.h"
+
+// Двоичный пакет уровней. Числа пишутся в порядке байтов машины (little-endian на x86 и ARM).
+//   заголовок (PackHeader) | записи уровней | индекс: count смещений uint64 от начала файла
+//   запись: высота, ширина (по байту), длина названия (uint16) и его байты, затем клетки по 3 бита
+//   (PackCell), младшие биты первыми, и байт выравнивания; в конце число букв (байт) и буквы:
+//   сначала ящиков, потом целей, каждые по порядку строк. Уровень без букв — 0 букв.
+// Пакет открывается через mmap; уровень читается прямо из отображения, без разбора текста.
+constexpr char kPackMagic[8] = {'S', 'K', 'B', 'P', 'A', 'C', 'K', '1'};
+constexpr uint32_t kPackVersion = 2;
+
+struct PackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t indexOffset;
+};
+
+enum class PackCell : uint8_t {
+    FLOOR = 0,
+    WALL = 1,
+    BOX = 2,
+    TARGET = 3,
+    BOX_ON_TARGET = 4,
+    PLAYER = 5,
+    PLAYER_ON_TARGET = 6
+};
+
+// Размер записи до байта числа букв: высота, ширина, длина названия, название, клетки и выравнивание
+constexpr size_t PackCellsEnd(size_t height, size_t width, size_t titleLength) {
+    return 4 + titleLength + (height * width * 3 + 7) / 8 + 1;
+}
+
+// Уровень внутри отображённого пакета: только указатели в запись, клетки декодируются по запросу
+class PackedLevel {
+   private:
+    const uint8_t* cells;
+    int height;
+    int width;
+    std::string_view title;
+    const uint8_t* letters;  // число букв, затем буквы
+
+   public:
+    PackedLevel(const uint8_t* record)
+        : height(record[0]), width(record[1]), title(reinterpret_cast<const char*>(record + 4), record[2] | record[3] << 8) {
+        cells = record + 4 + title.size();
+        letters = record + PackCellsEnd(height, width, title.size());
+    }
+    int GetHeight() const { return height; }
+    int GetWidth() const { return width; }
+    std::string_view GetTitle() const { return title; }
+    PackCell At(Point p) const {
+        size_t bit = size_t(p.y * width + p.x) * 3;
+        unsigned word = cells[bit / 8] | (unsigned(cells[bit / 8 + 1]) << 8);
+        return PackCell((word >> (bit % 8)) & 7);
+    }
+
+    // Состояние для поиска по толчкам с названием и буквами — как у ReadLevelCollection.
+    // Букв в записи не столько, сколько ящиков и целей, или буква не 'a'..'n' — runtime_error.
+    ParsedLevel ToParsed() const;
+    // Поле игры с буквами из записи; у уровня без букв ящики 'A'.. и цели 'a'.. идут по порядку
+    // строк, как у MapToStringStream. В формате игры ящик или игрок на цели не записывается —
+    // тогда runtime_error.
+    Field ToField() const;
+};
+
+// Пакет, отображённый в память. Доступ к уровню по номеру — O(1): смещение из индекса.
+// Конструктор проверяет заголовок и границы каждой записи — повреждённый пакет не открывается.
+class LevelPack {
+   private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    uint32_t count = 0;
+    const uint8_t* index = nullptr;
+
+   public:
+    explicit LevelPack(const std::string& fileName);
+    LevelPack(const LevelPack&) = delete;
+    LevelPack& operator=(const LevelPack&) = delete;
+    ~LevelPack();
+
+    size_t Size() const { return count; }
+    PackedLevel operator[](size_t i) const;
+};
+
+// Проверка по первым байтам, пакет ли это
+bool IsLevelPack(const std::string& fileName);
+
+// Записывает уровни в пакет; уровни больше 255 клеток по стороне и названия длиннее 65535 байт
+// не помещаются — runtime_error
+void WriteLevelPack(const std::string& fileName, const std::vector<ParsedLevel>& levels);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../inc/prog.h"
+
+// Готовый уровень из пула: текст карты (как MapToStringStream), параметры генерации и решение.
+// Решение — только направления толчков по порядку, без ходов игрока между ними (это не LURD);
+// ходы восстанавливает PushesToLurd, полную запись LURD печатает sokoban-solve.
+struct PooledLevel {
+    GeneratorParams params;
+    uint64_t hash;                // CanonicalLevelHash(text)
+    std::string text;
+    std::vector<Directions> solution;  // направления оптимальных толчков; pushes = solution.size()
+};
+
+// Хеш уровня, не зависящий от того, где в своей области стоит игрок
+uint64_t CanonicalLevelHash(const std::string& text);
+
+// Запись уровня в формате файла пула (её же пишут LevelPool::Add и sokoban-gen)
+void WritePooledLevel(std::ostream& out, const PooledLevel& level);
+
+struct GeneratorParamsHash {
+    size_t operator()(const GeneratorParams& p) const {
+        uint64_t key = 0;
+        for (int v : {p.height, p.width, p.targets, p.clusters, p.moves}) key = key * 1000003 + uint32_t(v);
+        return std::hash<uint64_t>()(key);
+    }
+};
+
+// Пул уже сгенерированных и решённых уровней в файле. Файл читается целиком в конструкторе
+// (повреждённый хвост отрезается), новые уровни дописываются в конец. Повторы (по CanonicalLevelHash) отбрасываются.
+// Draw отдаёт уровни нужных параметров по одному за O(1): каждый уровень — один раз за сессию,
+// потом nullopt, и вызывающий генерирует карту сам.
+class LevelPool {
+   private:
+    struct Bucket {
+        std::vector<size_t> order;  // индексы в levels, перемешаны при загрузке
+        size_t next = 0;            // order[0..next) уже выданы
+    };
+
+    std::string fileName;
+    std::mutex mutex;
+    std::vector<PooledLevel> levels;
+    std::unordered_set<uint64_t> hashes;
+    std::unordered_map<GeneratorParams, Bucket, GeneratorParamsHash> buckets;
+    std::mt19937 rng;
+
+    bool Insert(PooledLevel level);
+
+   public:
+    LevelPool(std::string fileName);
+    std::optional<PooledLevel> Draw(const GeneratorParams& params);
+    bool Add(PooledLevel level, bool drawn = true);
+    size_t Available(const GeneratorParams& params);
+    size_t Size();
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "../inc/pool.h"
+#include "../inc/prog.h"
+
+// Фоновая генерация карт: поток держит очередь из capacity готовых карт
+// (в текстовом виде MapToStringStream), главный поток забирает их без ожидания.
+// Если задан пул, карты сначала берутся из него, а новые сгенерированные дописываются в пул.
+class LevelPrefetcher {
+   private:
+    GeneratorParams params;
+    LevelPool* pool;
+    size_t capacity;
+    std::mutex mutex;
+    std::condition_variable_any changed;
+    std::deque<std::string> ready;
+    std::jthread worker;  // последним: останавливается и join-ится первым
+
+    void Run(std::stop_token stop);
+
+   public:
+    LevelPrefetcher(GeneratorParams p, LevelPool* pool = nullptr, size_t capacity = 3);
+    std::optional<std::string> TryPop();
+    size_t Ready();
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <chrono>
+#include <string>
+
+constexpr size_t kProfilerFrames = 600;  // 10 секунд при 60 Гц
+
+// Замеры кадров окна: время кадра целиком и по фазам, число вызовов draw за кадр.
+// Кадры пишутся всегда (это несколько чтений часов за кадр) в кольцевой буфер последних
+// kProfilerFrames кадров; оверлей по F3 показывает по ним перцентили времени кадра,
+// средние по фазам и сколько кадров пропустили vsync. Текст оверлея пересобирается
+// не чаще четырёх раз в секунду.
+class FrameProfiler {
+   public:
+    enum class Phase { EVENTS, DRAW, OVERLAY, DISPLAY, COUNT };
+
+    struct Frame {
+        float frameMs = 0;  // от начала кадра до начала следующего, вместе с ожиданием vsync
+        std::array<float, size_t(Phase::COUNT)> phaseMs{};
+        unsigned drawCalls = 0;
+    };
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    std::array<Frame, kProfilerFrames> frames;
+    size_t next = 0;       // куда ляжет следующий кадр
+    size_t stored = 0;     // сколько кадров в буфере
+    uint64_t counted = 0;  // сквозной номер следующего кадра — для CSV
+    Frame current;
+    Clock::time_point frameStart;
+    Clock::time_point lap;
+    bool started = false;
+
+    float budgetMs;
+    bool visible = false;
+    sf::Text text;
+    sf::RectangleShape background;
+    Clock::time_point lastRefresh;
+
+    void Refresh();
+
+   public:
+    explicit FrameProfiler(const sf::Font& font, float budgetMs = 1000.f / 60.f);
+
+    // Начало кадра: предыдущий кадр уходит в буфер
+    void BeginFrame();
+    // Время с прошлой отметки (начала кадра или прошлого Lap) добавляется к фазе
+    void Lap(Phase phase);
+    void AddDrawCalls(unsigned n) { current.drawCalls += n; }
+
+    void Toggle() { visible = !visible; }
+    bool IsVisible() const { return visible; }
+    size_t Size() const { return stored; }
+    // Кадр из буфера: 0 — самый старый
+    const Frame& At(size_t i) const { return frames[(next + kProfilerFrames - stored + i) % kProfilerFrames]; }
+
+    void Draw(sf::RenderTarget& target);
+    // Кадры буфера в CSV; false — файл не записался
+    bool ExportCsv(const std::string& fileName) const;
+};
+
+#endif
@@ -1,85 +1,280 @@
 #ifndef PROG_H
 #define PROG_H
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <queue>
 #include <set>
+#include <stop_token>
 #include <vector>
 
+#include "../inc/board.h"
 #include "../inc/field.h"
+#include "../inc/transposition.h"
 
 using namespace std;
 
-using Map = unordered_map<Point, BlockType>;
+using Map = MapGrid;
 
 int kbhit(void);
 
 bool IsWallType(BlockType t);
 
+// Узел поиска AI::BFS: компактное состояние и ссылка на родителя вместо копии Field и истории ходов
 struct State {
-    Field field;
-    std::vector<Directions> movesHistory;
+    BoardState board;
+    uint32_t parent;
+    Directions move;
+    uint64_t key;  // Zobrist-ключ board
 };
 
 struct ReverseMap {
     Point player;
     vector<Point> targets;
     vector<Point> boxes;
+    // Буквы формата игры ('a'..'n') по порядку boxes и targets; 0 или пустой вектор — без букв
+    // (генератор, XSB). Ящик с буквой засчитывается только на цели той же буквы, как в Field::HaveWon.
+    vector<char> boxLetters;
+    vector<char> targetLetters;
 };
 
 struct StateForGenerator {
-    unordered_map<Point, BlockType> map;
+    Map map;
     ReverseMap reverseMap;
     std::vector<Directions> movesHistory;
 };
 
-bool IsWallType(BlockType t);
+// Узел поиска по толчкам. Вместо копии карты и истории — только клетки ящиков (y * W + x),
+// игрок, толчок, которым сюда пришли, и индекс родителя в пуле узлов. Решение собирается
+// по ссылкам на родителей, когда цель уже найдена.
+struct PushNode {
+    array<Cell, kMaxBoxes> boxes;  // в порядке ReverseMap::boxes стартового состояния
+    uint8_t boxCount;
+    Cell player;
+    Directions push;
+    uint32_t parent;
+    uint64_t boxHash;  // Zobrist-ключ ящиков, обновляется при каждом толчке
+    uint64_t hash;     // ключ для visited: boxHash + левая верхняя клетка области игрока
+};
+
+// Каким поиском generator() проверяет карту. Все режимы возвращают оптимальное число толчков.
+enum class SolverMode {
+    BFS,          // BFSGenerated — полный перебор по слоям
+    ASTAR,        // A* с оценкой по паросочетанию ящиков и целей
+    IDASTAR,      // IDA* с той же оценкой, память — только путь и ограниченная таблица
+    AUTO,         // A* в пределах kAStarNodeBudget, иначе IDA*
+    PARALLEL_BFS,  // ParallelBFSGenerated — тот же BFS, слои раскрываются на всех ядрах
+    REVERSE,       // generator(): обратный поиск тягами от целей, проверка не нужна (FarthestPullState)
+    BIDIRECTIONAL  // BidirectionalBFSGenerated — толчки от старта и тяги от решения навстречу
+};
+
+constexpr uint16_t kInfDist = 0xFFFF;          // ящик из клетки не доходит до цели
+constexpr size_t kAStarNodeBudget = 200000;  // узлов A* до перехода на IDA*
+// IDA* после A* в режиме AUTO: таблица от собственного бюджета памяти (а не от числа узлов A*,
+// которого заведомо не хватило) и предел раскрытий — исчерпав его, попытка генератора отбрасывается
+constexpr size_t kIdaTableBytes = size_t(64) << 20;
+constexpr size_t kIdaNodeBudget = 20 * kAStarNodeBudget;
+
+// Неизменяемые таблицы уровня для поиска по толчкам
+struct PushLevel {
+    int H;
+    int W;
+    vector<uint8_t> wall;               // [y * W + x] — стена (ящики сюда не входят)
+    vector<Point> targets;
+    vector<vector<uint16_t>> pushDist;  // [цель][клетка] — толчков до цели без учёта других ящиков
+    vector<uint8_t> dead;               // [y * W + x] — ящик отсюда не дойдёт ни до одной цели
+    vector<uint8_t> target;             // [y * W + x] — цель
+    vector<char> targetLetter;          // [y * W + x] — буква цели, 0 — цель без буквы
+    vector<char> boxLetter;             // [ящик] — буква по порядку reverseMap.boxes, 0 — без буквы
+    vector<uint32_t> boxSlot;           // [ящик] — слот Zobrist: буква или kZobristBox
+    bool lettered = false;              // есть хоть одна цель с буквой
+};
+
+constexpr int kFreezeBudget = 32;       // ящиков на одну проверку заморозки
+constexpr int kCorralNodeBudget = 256;  // узлов подпоиска на один корал
+constexpr int kCorralsPerState = 4;     // сколько PI-коралов ищем при раскрытии состояния
+
+// Сколько раз срабатывала каждая проверка тупиков (и сколько раз проверка упёрлась в бюджет).
+// Считается локально в поиске, в общие счётчики попадает через SearchTally::Publish.
+struct DeadlockTally {
+    uint64_t simple = 0;
+    uint64_t freeze = 0;
+    uint64_t corral = 0;
+    uint64_t freezeBudgetHits = 0;
+    uint64_t corralBudgetHits = 0;
+    DeadlockTally& operator+=(const DeadlockTally& o);
+};
+
+// Статистика поисков и генератора. По умолчанию выключена: поиск считает в локальном
+// SearchTally и публикует итог один раз за поиск, генератор не читает часы — пока enabled
+// не поднят, общие счётчики никто не трогает.
+struct SearchCounters {
+    atomic<bool> enabled{false};
+
+    // поиски: BFSGenerated, ParallelBFSGenerated, A*, IDA*, обратный поиск генератора и AI::Solve
+    atomic<uint64_t> searches{0};
+    atomic<uint64_t> expanded{0};
+    atomic<uint64_t> generated{0};    // детей до проверки visited
+    atomic<uint64_t> duplicates{0};   // из них отброшено как уже встреченные
+    atomic<uint64_t> peakVisited{0};  // наибольший размер visited за один поиск
+    atomic<uint64_t> peakQueue{0};    // наибольшая очередь (у IDA* — глубина пути)
+    atomic<uint64_t> gaveUp{0};       // поиски, упёршиеся в бюджет узлов или памяти
+    atomic<uint64_t> astarFallbacks{0};  // SolveGenerated в режиме AUTO: A* сдался, решает IDA*
+
+    // проверки тупиков в этих поисках (DeadlockTally)
+    atomic<uint64_t> deadSimple{0};
+    atomic<uint64_t> deadFreeze{0};
+    atomic<uint64_t> deadCorral{0};
+    atomic<uint64_t> freezeBudgetHits{0};
+    atomic<uint64_t> corralBudgetHits{0};
+
+    // генератор: время фаз попыток по всем потокам и исходы попыток
+    atomic<uint64_t> levels{0};
+    atomic<uint64_t> generateNs{0};  // GenerateLevel целиком, по часам
+    atomic<uint64_t> wallsNs{0};
+    atomic<uint64_t> objectsNs{0};
+    atomic<uint64_t> searchNs{0};
+    atomic<uint64_t> attempts{0};
+    atomic<uint64_t> accepted{0};
+    atomic<uint64_t> rejectedNoRoom{0};      // не хватило места под ящики или цели
+    atomic<uint64_t> rejectedUnsolvable{0};
+    atomic<uint64_t> rejectedTooShort{0};    // решение короче movesQuantity
+    atomic<uint64_t> cancelled{0};           // попытку остановили: принята меньшая или внешний stop
+
+    void Reset();  // обнуляет счётчики, enabled не меняет
+    string ToJson() const;
+};
+
+// Счёт одного поиска в локальных переменных; Publish переносит его в GetSearchCounters()
+struct SearchTally {
+    uint64_t expanded = 0;
+    uint64_t generated = 0;
+    uint64_t duplicates = 0;
+    uint64_t peakVisited = 0;
+    uint64_t peakQueue = 0;
+    bool gaveUp = false;
+    DeadlockTally deadlocks;
+    void Queue(size_t size) { peakQueue = std::max<uint64_t>(peakQueue, size); }
+    void Publish() const;
+};
+
+// Карта генератора вместе с оптимальным решением: направления толчков из movesHistory
+struct GeneratedMap {
+    Map map;
+    vector<Directions> solution;
+};
+
+// Рамка и numClusters случайных стен — первый шаг каждой попытки генерации
+Map PlaceWalls(int mapHeight, int mapWidth, int numClusters, mt19937& rng);
+
+// threads = 0 — по потоку на ядро, 1 — попытки по очереди в вызывающем потоке.
+// С заданным seed карта воспроизводима (при любом threads), без него — зерно из random_device.
+GeneratedMap GenerateLevel(int mapHeight, int mapWidth, int targets, int numClusters, int movesQuantity, SolverMode solver = SolverMode::AUTO, unsigned threads = 0, stop_token stop = {}, optional<uint32_t> seed = nullopt);
+
+Map generator(int mapHeight, int mapWidth, int targets, int numClusters, int movesQuantity, SolverMode solver = SolverMode::AUTO, unsigned threads = 0, stop_token stop = {});
+
+// Параметры generator(), как их задаёт main
+struct GeneratorParams {
+    int height;
+    int width;
+    int targets;
+    int clusters;
+    int moves;
+
+    bool operator==(const GeneratorParams&) const = default;
+};
+
+stringstream MapToStringStream(Map& placedBlocks, int& mapHeight, int& mapWidth);
+
+vector<uint8_t> Occupancy(const PushNode& n, const PushLevel& level);
+
+vector<uint8_t> ReachableCells(const vector<uint8_t>& occ, Cell player, int H, int W, Cell& top);
+
+PushNode MakePushNode(const StateForGenerator& s, const PushLevel& level);
+
+bool IsSolvedPushNode(const PushNode& n, const PushLevel& level);
+
+vector<Directions> PushPath(const vector<PushNode>& nodes, uint32_t goal);
+
+StateForGenerator SolvedState(const StateForGenerator& start, const PushNode& goal, vector<Directions> pushes, const PushLevel& level);
+
+vector<PushNode> GenerateNeighbors(const PushNode& current, uint32_t index, const PushLevel& level, DeadlockTally& deadlocks);
+
+// Таблица встреченных состояний и узлы вместе укладываются в memBytes; когда таблица заполнена,
+// поиск сдаётся и возвращает пустое состояние, как при отсутствии решения
+StateForGenerator BFSGenerated(const StateForGenerator& start, int H, int W, stop_token stop = {}, size_t memBytes = kSearchMemoryBytes);
+
+PushLevel BuildPushLevel(const StateForGenerator& start, int H, int W);
+
+SearchCounters& GetSearchCounters();
+
+bool IsFreezeDeadlock(const vector<uint8_t>& occ, const PushLevel& level, Point box, DeadlockTally& deadlocks);
+
+bool IsCorralDeadlock(const PushNode& s, const PushLevel& level, const vector<uint8_t>& reach, DeadlockTally& deadlocks);
+
+int MatchingLowerBound(const PushLevel& level, const PushNode& n);
 
-unordered_map<Point, BlockType> generator(int mapHeight, int mapWidth, int targets, int numClusters, int movesQuantity);
+optional<StateForGenerator> AStarGenerated(const StateForGenerator& start, int H, int W, size_t maxNodes, stop_token stop = {});
 
-stringstream MapToStringStream(unordered_map<Point, BlockType>& placedBlocks, int& mapHeight, int& mapWidth);
+// maxExpanded — предел раскрытых узлов; исчерпав его, поиск сдаётся и возвращает пустое состояние
+StateForGenerator IDAStarGenerated(const StateForGenerator& start, int H, int W, size_t maxTable, stop_token stop = {},
+                                   size_t maxExpanded = SIZE_MAX);
 
-string SerializeMapForHash(const unordered_map<Point, BlockType>& map, int height, int width);
+// Память visited и узлов — memBytes, как у BFSGenerated; заполнилась — поиск сдаётся
+StateForGenerator ParallelBFSGenerated(const StateForGenerator& start, int H, int W, unsigned threads, stop_token stop = {},
+                                       size_t memBytes = kSearchMemoryBytes);
 
-std::string SerializeState(const StateForGenerator& s, int h, int w);
+StateForGenerator SolveGenerated(const StateForGenerator& start, int H, int W, SolverMode mode, stop_token stop = {});
 
-vector<StateForGenerator> GenerateNeighbors(StateForGenerator& current);
+StateForGenerator FarthestPullState(const StateForGenerator& goal, int H, int W, size_t maxNodes, stop_token stop = {});
 
-StateForGenerator BFSGenerated(const StateForGenerator& start, int H, int W);
+StateForGenerator BidirectionalBFSGenerated(const StateForGenerator& start, int H, int W, stop_token stop = {}, size_t memBytes = kSearchMemoryBytes);
 
 bool CanMoveMap(Point direction, StateForGenerator& state);
 
-bool IsEmptySpaceMap(unordered_map<Point, BlockType>& PlacedBlocks, const Point& pos);
+bool IsEmptySpaceMap(Map& PlacedBlocks, const Point& pos);
 
-bool IsBoxMap(unordered_map<Point, BlockType>& PlacedBlocks, Point& pos);
+bool IsBoxMap(Map& PlacedBlocks, Point& pos);
 
 Directions PointToDirection(Point p);
 
 bool MoveMap(Point direction, StateForGenerator& state);
 
+// Все ящики на целях, на целях с буквой — ящики той же буквы; пустое состояние (результат
+// поиска без решения) — не победа
 bool HaveWonMap(const StateForGenerator& s);
 
-ReverseMap BuildReverseMap(const std::unordered_map<Point, BlockType>& map);
+ReverseMap BuildReverseMap(const Map& map);
 
 class AI {
    private:
     /* data */
     std::shared_ptr<GameDescriptor> game;
-    State initialState;
+    Field initialField;
+    Board board;
+    BoardState initialState;
 
    public:
     AI(std::shared_ptr<GameDescriptor> g, Field& f);
-    vector<State> GenerateNeighbors(State& current, StepAnim& anim);
+    int GenerateNeighbors(const State& current, uint32_t index, array<State, 4>& next) const;
+    // Пустой результат — решения нет или таблица состояний и узлы упёрлись в memBytes
+    optional<vector<Directions>> Solve(size_t memBytes = kSearchMemoryBytes) const;
     void BFS(Field& f, StepAnim& anim);
 };
 
-inline bool InBounds(Point p, int H, int W) noexcept;
+inline bool InBounds(Point p, int H, int W) noexcept {
+    return p.x >= 0 && p.x < W && p.y >= 0 && p.y < H;
+}
 
-inline bool IsSolid(const Map& m, Point p) noexcept;
+inline bool IsSolid(const Map& m, Point p) noexcept {
+    BlockType t = m.At(p);
+    return IsWallType(t) || t == BlockType::BOX;
+}
 
 vector<uint8_t> ComputeReachableFlat(const Map& m, Point player, int H, int W);
 // тогда между крайним блоком может быть расстояние в один блок между другим блоком. Также мы проверяем является ли этот блок кластером его координаты.
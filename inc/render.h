@@ -0,0 +1,70 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "../inc/field.h"
+
+// Квадраты глифов одного шрифта и размера: прямоугольник в текстуре шрифта и смещение
+// от базовой линии. Берутся из sf::Font один раз в конструкторе, дальше только копируются
+// в вершинный массив.
+class GlyphCache {
+   private:
+    struct Quad {
+        sf::FloatRect bounds;  // относительно базовой линии
+        sf::FloatRect tex;     // в пикселях текстуры шрифта
+    };
+
+    const sf::Font& font;
+    unsigned characterSize;
+    std::array<Quad, 128> quads;  // ASCII
+
+   public:
+    GlyphCache(const sf::Font& font, unsigned characterSize);
+    const sf::Texture& GetTexture() const { return font.getTexture(characterSize); }
+    void AppendCentered(sf::VertexArray& va, char c, sf::FloatRect cell, sf::Color color) const;
+};
+
+// Отрисовка поля. Пол, стены и цели уровня не меняются — они рисуются один раз в Load
+// в RenderTexture. Ящики и игрок («фигуры») хранятся списком и обновляются только по
+// клеткам, которые изменил Field::Move, так что работа за кадр не зависит от площади поля.
+// Фигуры рисуются двумя вызовами draw (прямоугольники и буквы с текстурой шрифта),
+// анимируемые игрок и ящик — ещё одной такой же парой поверх.
+class BoardRenderer {
+   private:
+    struct Layer {
+        sf::VertexArray cells{sf::PrimitiveType::Triangles};
+        sf::VertexArray letters{sf::PrimitiveType::Triangles};
+    };
+
+    struct Piece {
+        Point pos;
+        char ch;  // буква ящика или 'x'
+    };
+
+    GlyphCache glyphs;
+    sf::RenderTexture staticLayer;
+    std::vector<Piece> pieces;
+    Layer dynamic;
+    Layer moving;
+    mutable unsigned drawCalls = 0;  // с прошлого TakeDrawCalls, для FrameProfiler
+
+    void Add(Layer& layer, sf::Vector2f pos, sf::Color color, char letter);
+    void Draw(sf::RenderTarget& target, const Layer& layer) const;
+
+   public:
+    explicit BoardRenderer(const sf::Font& font);
+    void Load(Field& f);
+    void Update(Field& f, const std::vector<Point>& dirty);
+    void Clear();
+    void AddPieces(bool hidePlayer, std::optional<Point> hideBoxAt = std::nullopt);
+    void AddMoving(sf::Vector2f pos, sf::Color color, char letter = 0) { Add(moving, pos, color, letter); }
+    void Draw(sf::RenderTarget& target) const;
+    unsigned TakeDrawCalls() { return std::exchange(drawCalls, 0u); }
+};
+
+#endif
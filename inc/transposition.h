@@ -0,0 +1,113 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+constexpr size_t kSearchMemoryBytes = size_t(256) << 20;  // бюджет памяти одного поиска по умолчанию
+
+// Что делать, когда таблица дошла до бюджета
+enum class TableFullPolicy {
+    GIVE_UP,  // новый ключ не вставляется, Insert возвращает FULL — поиск сдаётся
+    REPLACE   // новый ключ затирает запись в своей домашней ячейке (для кэшей вроде таблицы IDA*);
+              // если домашняя ячейка пуста, ключ не запоминается и Insert возвращает FULL —
+              // занять её значило бы съесть пустую ячейку, на которой останавливается пробирование
+};
+
+enum class TableInsert { INSERTED, FOUND, FULL };
+
+// Таблица встреченных состояний: открытая адресация с линейным пробированием, запись —
+// Zobrist-ключ и 32-битное значение (глубина, g или номер узла), 12 байт без выравнивания,
+// вместо отдельного узла unordered_set в куче и корзины. Ключ 0 занят под пустую ячейку,
+// поэтому хранится как 1.
+// Таблица растёт удвоением, пока заполнена на 3/4, но не больше бюджета памяти: потолок памяти
+// самой таблицы известен заранее. Узлы поиска лежат отдельно — см. SearchTableBytes.
+class TranspositionTable {
+   public:
+    // ключ двумя половинами — так в записи нет выравнивания до 16 байт
+    struct Entry {
+        uint32_t keyLow;
+        uint32_t keyHigh;
+        uint32_t value;
+        uint64_t Key() const { return uint64_t(keyHigh) << 32 | keyLow; }
+    };
+    static constexpr size_t kEntryBytes = sizeof(Entry);
+
+   private:
+    std::unique_ptr<Entry[]> entries;
+    size_t mask = 0;
+    int shift = 64;  // 64 - log2(ёмкости)
+    size_t size = 0;
+    size_t maxCapacity;
+    TableFullPolicy policy;
+
+    static uint64_t Stored(uint64_t key) { return key == 0 ? 1 : key; }
+    // Ячейка — старшие биты ключа после домножения (фибоначчиево хеширование)
+    size_t Home(uint64_t key) const { return size_t((key * 0x9E3779B97F4A7C15ull) >> shift); }
+    void Grow();
+
+   public:
+    explicit TranspositionTable(size_t memBytes = kSearchMemoryBytes, TableFullPolicy policy = TableFullPolicy::GIVE_UP);
+
+    // Значение ключа или nullptr
+    uint32_t* Find(uint64_t key) {
+        key = Stored(key);
+        for (size_t i = Home(key);; i = (i + 1) & mask) {
+            const uint64_t k = entries[i].Key();
+            if (k == key)
+                return &entries[i].value;
+            if (k == 0)
+                return nullptr;
+        }
+    }
+
+    // Вставка нового ключа. FOUND — ключ уже был, его значение не меняется (slot указывает на него);
+    // FULL — места нет, ключ не запомнен (slot == nullptr).
+    TableInsert Insert(uint64_t key, uint32_t value, uint32_t** slot = nullptr) {
+        key = Stored(key);
+        if ((size + 1) * 4 > (mask + 1) * 3 && mask + 1 < maxCapacity)
+            Grow();
+        size_t i = Home(key);
+        for (;; i = (i + 1) & mask) {
+            const uint64_t k = entries[i].Key();
+            if (k == key) {
+                if (slot)
+                    *slot = &entries[i].value;
+                return TableInsert::FOUND;
+            }
+            if (k == 0)
+                break;
+        }
+        if ((size + 1) * 4 > (mask + 1) * 3) {
+            // REPLACE: ячейка остаётся занятой, поэтому цепочки других ключей не рвутся
+            if (policy == TableFullPolicy::REPLACE)
+                i = Home(key);
+            if (policy == TableFullPolicy::GIVE_UP || entries[i].Key() == 0) {
+                if (slot)
+                    *slot = nullptr;
+                return TableInsert::FULL;
+            }
+        } else {
+            size++;
+        }
+        entries[i] = {uint32_t(key), uint32_t(key >> 32), value};
+        if (slot)
+            *slot = &entries[i].value;
+        return TableInsert::INSERTED;
+    }
+
+    void Clear();
+    size_t Size() const { return size; }
+    size_t Capacity() const { return mask + 1; }
+    size_t MemoryBytes() const { return Capacity() * kEntryBytes; }
+};
+
+// Доля бюджета поиска под таблицу, когда на каждое встреченное состояние поиск держит ещё
+// nodeBytes в векторах узлов. Таблица ёмкостью C хранит до 3/4·C состояний, а вектор при
+// росте удвоением на время переноса занимает до трёх своих размеров: всего C·(запись + 9/4 узла).
+constexpr size_t SearchTableBytes(size_t searchBytes, size_t nodeBytes) {
+    return searchBytes / (TranspositionTable::kEntryBytes + nodeBytes * 9 / 4) * TranspositionTable::kEntryBytes;
+}
+
+#endif
@@ -0,0 +1,233 @@
+// sokoban_bench — замеры генератора и поисков без окна.
+// Корпус уровней строится из фиксированного зерна, поэтому между версиями сравниваются
+// одни и те же карты. Результат — по строке JSON на замер в stdout:
+//   {"bench":"bfs_generated","size":"10x10","boxes":2,"levels":6,"reps":1,"wall_ms":12.3,
+//    "items":4567,"unit":"nodes","items_per_sec":371300,"peak_bytes":1048576}
+// peak_bytes — пик кучи во время замера сверх того, что было занято до него.
+// Запуск: sokoban_bench [зерно]
+#include <sys/resource.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../inc/field.h"
+#include "../inc/prog.h"
+
+// Учёт кучи: перед каждым блоком хранится его размер, пик считается по всем потокам
+static std::atomic<size_t> heapInUse{0};
+static std::atomic<size_t> heapPeak{0};
+
+constexpr size_t kHeader = alignof(std::max_align_t);
+
+void* operator new(size_t size) {
+    void* raw = std::malloc(size + kHeader);
+    if (!raw)
+        throw std::bad_alloc();
+    *static_cast<size_t*>(raw) = size;
+    size_t now = heapInUse += size;
+    size_t peak = heapPeak.load(std::memory_order_relaxed);
+    while (now > peak && !heapPeak.compare_exchange_weak(peak, now)) {
+    }
+    return static_cast<char*>(raw) + kHeader;
+}
+
+// Освобождение общее для всех operator delete: размер берётся из заголовка блока.
+// Не встраивается, иначе GCC видит free() на указателе из operator new (-Wmismatched-new-delete).
+[[gnu::noinline]] static void Release(void* p) noexcept {
+    if (!p)
+        return;
+    void* raw = static_cast<char*>(p) - kHeader;
+    heapInUse -= *static_cast<size_t*>(raw);
+    std::free(raw);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { Release(p); }
+void operator delete[](void* p) noexcept { Release(p); }
+void operator delete(void* p, size_t) noexcept { Release(p); }
+void operator delete[](void* p, size_t) noexcept { Release(p); }
+
+struct BenchLevel {
+    Map map;                  // игровая карта: стены, ящики, игрок, цели
+    StateForGenerator start;  // то же без игрока и целей — вход поиска генератора
+    Point player;
+    int pushes;
+};
+
+struct BenchSet {
+    int H;
+    int W;
+    int boxes;
+    int clusters;
+    vector<BenchLevel> levels;
+};
+
+// Уровень как у GenerateAttempt, но все случайные решения берутся из rng.
+// Принимается только решаемый уровень не короче boxes * 2 толчков.
+static optional<BenchLevel> MakeBenchLevel(int H, int W, int boxes, int clusters, mt19937& rng) {
+    Map placed = PlaceWalls(H, W, clusters, rng);
+    auto inside = [&](int margin) {
+        return [=](Point p) { return p.x >= margin && p.x <= W - 1 - margin && p.y >= margin && p.y <= H - 1 - margin; };
+    };
+    ReverseMap rev;
+    for (int i = 0; i < boxes; i++) {
+        optional<Point> b = placed.RandomFree(rng, inside(2));
+        if (!b)
+            return nullopt;
+        placed.Set(*b, BlockType::BOX);
+        rev.boxes.push_back(*b);
+    }
+    optional<Point> player = placed.RandomFree(rng, inside(1));
+    if (!player)
+        return nullopt;
+    placed.Set(*player, BlockType::PLAYER);
+    rev.player = *player;
+    for (int i = 0; i < boxes; i++) {
+        optional<Point> t = placed.RandomFree(rng, inside(1));
+        if (!t)
+            return nullopt;
+        placed.Set(*t, BlockType::TARGET);
+        rev.targets.push_back(*t);
+    }
+
+    Map solid = placed;
+    solid.Set(rev.player, BlockType::EMPTY);
+    for (const auto& t : rev.targets) solid.Set(t, BlockType::EMPTY);
+    StateForGenerator start{solid, rev, {}};
+    StateForGenerator solved = BFSGenerated(start, H, W);
+    if (!HaveWonMap(solved) || solved.movesHistory.size() < size_t(boxes * 2))
+        return nullopt;
+    return BenchLevel{placed, start, rev.player, int(solved.movesHistory.size())};
+}
+
+static Field MakeField(BenchLevel& level, int H, int W) {
+    stringstream ss = MapToStringStream(level.map, H, W);
+    return Field(ss);
+}
+
+struct Measure {
+    double ms;
+    size_t peak;
+};
+
+static Measure Run(const std::function<void()>& body) {
+    size_t base = heapInUse.load();
+    heapPeak = base;
+    auto t0 = std::chrono::steady_clock::now();
+    body();
+    auto t1 = std::chrono::steady_clock::now();
+    return {std::chrono::duration<double, std::milli>(t1 - t0).count(), heapPeak.load() - base};
+}
+
+static void Report(const char* bench, const BenchSet& set, int reps, Measure m, uint64_t items, const char* unit) {
+    double perSec = m.ms > 0 ? items * 1000.0 / m.ms : 0;
+    std::printf(
+        "{\"bench\":\"%s\",\"size\":\"%dx%d\",\"boxes\":%d,\"levels\":%zu,\"reps\":%d,\"wall_ms\":%.3f,"
+        "\"items\":%llu,\"unit\":\"%s\",\"items_per_sec\":%.0f,\"peak_bytes\":%zu}\n",
+        bench, set.H, set.W, set.boxes, set.levels.size(), reps, m.ms, (unsigned long long)items, unit, perSec, m.peak);
+    std::fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    const unsigned seed = argc > 1 ? unsigned(std::stoul(argv[1])) : 20240601u;
+    constexpr int kLevelsPerSet = 6;
+    constexpr int kCopyReps = 20000;
+    constexpr int kReachReps = 2000;
+
+    GetSearchCounters().enabled = true;  // bfs_generated и ai_bfs берут число узлов из статистики
+
+    vector<BenchSet> sets{{8, 8, 2, 20, {}}, {10, 10, 2, 40, {}}, {14, 14, 2, 150, {}}, {12, 12, 3, 60, {}}};
+    for (auto& set : sets) {
+        mt19937 rng(seed ^ unsigned(set.H * 1000 + set.boxes));
+        for (int tries = 0; (int)set.levels.size() < kLevelsPerSet && tries < 10000; tries++) {
+            if (auto level = MakeBenchLevel(set.H, set.W, set.boxes, set.clusters, rng))
+                set.levels.push_back(std::move(*level));
+        }
+    }
+
+    for (auto& set : sets) {
+        const int H = set.H;
+        const int W = set.W;
+
+        GetSearchCounters().Reset();
+        Measure m = Run([&] {
+            for (auto& level : set.levels) BFSGenerated(level.start, H, W);
+        });
+        Report("bfs_generated", set, 1, m, GetSearchCounters().expanded, "nodes");
+
+        GetSearchCounters().Reset();
+        m = Run([&] {
+            for (auto& level : set.levels) BidirectionalBFSGenerated(level.start, H, W);
+        });
+        Report("bfs_bidirectional", set, 1, m, GetSearchCounters().expanded, "nodes");
+
+        GetSearchCounters().Reset();
+        m = Run([&] {
+            for (auto& level : set.levels) ParallelBFSGenerated(level.start, H, W, 0);
+        });
+        Report("parallel_bfs", set, 1, m, GetSearchCounters().expanded, "nodes");
+
+        vector<Field> fields;
+        for (auto& level : set.levels) fields.push_back(MakeField(level, H, W));
+
+        // AI различает ящики по буквам, его пространство состояний с тремя ящиками — гигабайты
+        if (set.boxes <= 2) {
+            GetSearchCounters().Reset();
+            m = Run([&] {
+                for (auto& f : fields) {
+                    auto g = std::make_shared<GameDescriptor>(f);
+                    f.SetGame(g);
+                    AI(g, f).Solve();
+                }
+            });
+            Report("ai_bfs", set, 1, m, GetSearchCounters().expanded, "nodes");
+        }
+
+        m = Run([&] {
+            for (int r = 0; r < kReachReps; r++)
+                for (auto& level : set.levels) ComputeReachableFlat(level.map, level.player, H, W);
+        });
+        Report("reachable_flat", set, kReachReps, m, uint64_t(kReachReps) * set.levels.size(), "calls");
+
+        m = Run([&] {
+            for (int r = 0; r < kReachReps; r++)
+                for (auto& level : set.levels) MapToStringStream(level.map, set.H, set.W);
+        });
+        Report("map_to_stringstream", set, kReachReps, m, uint64_t(kReachReps) * set.levels.size(), "calls");
+
+        m = Run([&] {
+            for (int r = 0; r < kCopyReps; r++)
+                for (const auto& f : fields) Field copy(f);
+        });
+        Report("field_copy", set, kCopyReps, m, uint64_t(kCopyReps) * fields.size(), "ops");
+
+        m = Run([&] {
+            for (int r = 0; r < kCopyReps; r++)
+                for (auto& f : fields) {
+                    Field moved(std::move(f));
+                    f = std::move(moved);
+                }
+        });
+        Report("field_move", set, kCopyReps, m, uint64_t(kCopyReps) * fields.size() * 2, "ops");
+
+        // генерация целиком, в одном потоке и с тем же зерном — чтобы число не зависело от машины
+        constexpr int kGenerated = 3;
+        m = Run([&] {
+            for (int i = 0; i < kGenerated; i++)
+                GenerateLevel(H, W, set.boxes, set.clusters, set.boxes * 2, SolverMode::AUTO, 1, {}, seed + i);
+        });
+        Report("generator", set, kGenerated, m, kGenerated, "levels");
+    }
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    std::printf("{\"bench\":\"process\",\"max_rss_kb\":%ld}\n", usage.ru_maxrss);
+    return 0;
+}
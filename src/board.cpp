@@ -0,0 +1,90 @@
+#include "../inc/board.h"
+
+Board::Board(Field& emptyField) {
+    width = emptyField.GetWidth();
+    height = emptyField.GetHeight();
+    stride = width + 2;
+    floor.assign(stride * (height + 2), 0);
+    goals.fill(kNoCell);
+    offsets = {-1, 1, -stride, stride};
+
+    Point p;
+    for (p.y = 0; p.y < height; p.y++) {
+        for (p.x = 0; p.x < width; p.x++) {
+            char cell = emptyField.GetCell(p);
+            if (cell == ' ' || (cell >= 'a' && cell < 'o')) {
+                floor[ToCell(p)] = 1;
+            }
+            if (cell >= 'a' && cell < 'o') {
+                goals[cell - 'a'] = ToCell(p);
+            }
+        }
+    }
+}
+
+// Снимок ящиков и игрока с живого поля
+BoardState Board::MakeState(Field& f) const {
+    BoardState s;
+    s.boxes.fill(kNoCell);
+    s.player = kNoCell;
+    Point p;
+    for (p.y = 0; p.y < height; p.y++) {
+        for (p.x = 0; p.x < width; p.x++) {
+            char cell = f.GetCell(p);
+            if (cell == 'x') {
+                s.player = ToCell(p);
+            } else if (cell >= 'A' && cell < 'O') {
+                s.boxes[cell - 'A'] = ToCell(p);
+            }
+        }
+    }
+    return s;
+}
+
+// Буква ящика в клетке c или -1
+int Board::BoxAt(const BoardState& s, Cell c) const {
+    for (int i = 0; i < kMaxBoxes; i++) {
+        if (s.boxes[i] == c)
+            return i;
+    }
+    return -1;
+}
+
+// Полный Zobrist-ключ состояния; дальше он обновляется в TryMove за O(1)
+uint64_t Board::Hash(const BoardState& s) const {
+    uint64_t key = ZobristKey(kZobristPlayer, s.player);
+    for (int i = 0; i < kMaxBoxes; i++) {
+        if (s.boxes[i] != kNoCell)
+            key ^= ZobristKey(i, s.boxes[i]);
+    }
+    return key;
+}
+
+// Те же правила, что и Field::Move: шаг на свободную клетку или толчок ящика на свободную клетку
+bool Board::TryMove(BoardState& s, Directions d, uint64_t& key) const {
+    int dv = offsets[(int)d];
+    Cell next = Cell(s.player + dv);
+    if (!floor[next])
+        return false;
+
+    int box = BoxAt(s, next);
+    if (box >= 0) {
+        Cell dest = Cell(next + dv);
+        if (!floor[dest] || BoxAt(s, dest) >= 0)
+            return false;
+        s.boxes[box] = dest;
+        key ^= ZobristKey(box, next) ^ ZobristKey(box, dest);
+    }
+    key ^= ZobristKey(kZobristPlayer, s.player) ^ ZobristKey(kZobristPlayer, next);
+    s.player = next;
+    return true;
+}
+
+// Как Field::HaveWon: на каждой цели стоит ящик с той же буквой
+bool Board::IsSolved(const BoardState& s) const {
+    for (int i = 0; i < kMaxBoxes; i++) {
+        if (goals[i] != kNoCell && s.boxes[i] != goals[i])
+            return false;
+    }
+    return true;
+}
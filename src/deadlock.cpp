@@ -0,0 +1,272 @@
+// Динамические тупики для поиска по толчкам: замороженные ящики и PI-коралы
+#include <algorithm>
+#include <queue>
+#include <unordered_set>
+
+#include "../inc/prog.h"
+
+static const std::array<Point, 4> kDirs{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+
+DeadlockTally& DeadlockTally::operator+=(const DeadlockTally& o) {
+    simple += o.simple;
+    freeze += o.freeze;
+    corral += o.corral;
+    freezeBudgetHits += o.freezeBudgetHits;
+    corralBudgetHits += o.corralBudgetHits;
+    return *this;
+}
+
+namespace {
+
+// Проверка заморозки: ящик заморожен, если его нельзя сдвинуть ни по горизонтали, ни по вертикали.
+// Ось заблокирована, если с одной из сторон стена (или ящик, который мы уже проверяем — он
+// считается стеной), с обеих сторон простые тупики, или рядом ящик, который сам заморожен.
+struct FreezeCheck {
+    const std::vector<uint8_t>& occ;  // сетка занятости: 2 — ящик
+    const PushLevel& level;
+    int budget = kFreezeBudget;
+    bool exhausted = false;
+    std::vector<Point> chain;   // ящики на текущем пути рекурсии — считаются стенами
+    std::vector<Point> frozen;  // ящики, для которых заморозка доказана
+
+    bool IsWall(Point p) const {
+        return !InBounds(p, level.H, level.W) || level.wall[p.y * level.W + p.x];
+    }
+
+    bool IsBox(Point p) const {
+        return InBounds(p, level.H, level.W) && occ[p.y * level.W + p.x] == 2;
+    }
+
+    bool InChain(Point p) const {
+        return std::find(chain.begin(), chain.end(), p) != chain.end();
+    }
+
+    bool Blocked(Point b, Point axis) {
+        Point a = b - axis;
+        Point c = b + axis;
+        if (IsWall(a) || IsWall(c) || InChain(a) || InChain(c))
+            return true;
+        if (level.dead[a.y * level.W + a.x] && level.dead[c.y * level.W + c.x])
+            return true;
+        return (IsBox(a) && Frozen(a)) || (IsBox(c) && Frozen(c));
+    }
+
+    bool Frozen(Point b) {
+        if (--budget < 0) {
+            exhausted = true;
+            return false;
+        }
+        size_t mark = frozen.size();
+        chain.push_back(b);
+        bool result = Blocked(b, {1, 0}) && Blocked(b, {0, 1});
+        chain.pop_back();
+        if (result)
+            frozen.push_back(b);
+        else
+            frozen.resize(mark);  // доказательства внутри неудачной ветки не в счёт
+        return result;
+    }
+};
+
+// Состояние подзадачи корала: только ящики барьера и игрок
+struct CorralNode {
+    std::vector<Point> boxes;
+    Point player;
+};
+
+}  // namespace
+
+bool IsFreezeDeadlock(const std::vector<uint8_t>& occ, const PushLevel& level, Point box, DeadlockTally& deadlocks) {
+    FreezeCheck check{occ, level, kFreezeBudget, false, {}, {}};
+    bool frozen = check.Frozen(box);
+    if (check.exhausted) {
+        deadlocks.freezeBudgetHits++;
+        return false;  // не успели доказать — считаем, что тупика нет
+    }
+    if (!frozen)
+        return false;
+    for (Point p : check.frozen) {
+        if (!level.target[p.y * level.W + p.x]) {
+            deadlocks.freeze++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Коралы — области, куда игрок не может попасть без толчка. Для каждого PI-корала (все возможные
+// толчки ящиков его барьера ведут внутрь, и игрок может встать для каждого такого толчка)
+// запускаем маленький поиск, в котором оставлены только ящики барьера. Остальные ящики убраны,
+// так что подзадача только проще исходной: если в ней нельзя ни открыть корал, ни расставить
+// его ящики по целям, то исходное состояние — тупик. Поиск ограничен kCorralNodeBudget узлами.
+bool IsCorralDeadlock(const PushNode& s, const PushLevel& level, const std::vector<uint8_t>& reach, DeadlockTally& deadlocks) {
+    const int H = level.H;
+    const int W = level.W;
+    const int N = H * W;
+    auto idx = [W](Point p) { return p.y * W + p.x; };
+
+    std::vector<Point> boxes;
+    std::vector<uint8_t> box(N, 0);
+    for (int i = 0; i < s.boxCount; i++) {
+        boxes.push_back({s.boxes[i] % W, s.boxes[i] / W});
+        box[s.boxes[i]] = 1;
+    }
+    const Point player{s.player % W, s.player / W};
+
+    // разметка коралов: связные области пустых клеток вне reach
+    std::vector<int> corral(N, -1);
+    int corralCount = 0;
+    for (int c = 0; c < N; c++) {
+        if (level.wall[c] || box[c] || reach[c] || corral[c] >= 0)
+            continue;
+        std::queue<int> q;
+        q.push(c);
+        corral[c] = corralCount;
+        while (!q.empty()) {
+            Point u{q.front() % W, q.front() / W};
+            q.pop();
+            for (Point d : kDirs) {
+                Point v = u + d;
+                if (!InBounds(v, H, W))
+                    continue;
+                int vi = idx(v);
+                if (level.wall[vi] || box[vi] || reach[vi] || corral[vi] >= 0)
+                    continue;
+                corral[vi] = corralCount;
+                q.push(vi);
+            }
+        }
+        corralCount++;
+    }
+
+    // сетка ящиков и область игрока узла подзадачи — общие для всех узлов, после узла
+    // очищаются только тронутые клетки; cells — очередь обхода и список достигнутых клеток
+    std::vector<uint8_t> grid(N, 0), r(N, 0);
+    std::vector<int> cells;
+    cells.reserve(N);
+    std::vector<int> innerTargets;
+    int searched = 0;  // в лимит kCorralsPerState идут только коралы, для которых запущен поиск
+    for (int id = 0; id < corralCount && searched < kCorralsPerState; id++) {
+        // барьер корала и проверка PI
+        std::vector<Point> barrier;
+        for (Point b : boxes) {
+            for (Point d : kDirs) {
+                Point v = b + d;
+                if (InBounds(v, H, W) && corral[idx(v)] == id) {
+                    barrier.push_back(b);
+                    break;
+                }
+            }
+        }
+
+        bool pi = true;
+        bool solved = true;
+        for (Point b : barrier) {
+            solved &= bool(level.target[idx(b)]);
+            for (Point d : kDirs) {
+                Point dest = b + d;
+                Point from = b - d;
+                if (!InBounds(dest, H, W) || !InBounds(from, H, W))
+                    continue;
+                int di = idx(dest), fi = idx(from);
+                if (level.wall[di] || level.wall[fi] || box[di] || level.dead[di])
+                    continue;  // толчок невозможен
+                if (corral[di] == id) {
+                    pi &= reach[fi] != 0;  // I: игрок должен уметь встать за ящик
+                } else if (reach[fi]) {
+                    pi = false;  // P: ящик барьера можно вытолкнуть наружу
+                }
+            }
+        }
+        innerTargets.clear();
+        for (int c = 0; c < N; c++) {
+            if (corral[c] == id && level.target[c])
+                innerTargets.push_back(c);
+        }
+        solved &= innerTargets.empty();  // внутри пустая цель — корал не решён
+        if (!pi || solved)
+            continue;
+        searched++;
+
+        // подзадача: только ящики барьера, успех — игрок попал в корал или барьер стоит на целях
+        auto success = [&](const CorralNode& n) {
+            for (int c : cells) {
+                if (corral[c] == id)
+                    return true;
+            }
+            for (Point b : n.boxes) {
+                if (!level.target[idx(b)])
+                    return false;
+            }
+            for (int c : innerTargets) {
+                if (!grid[c])
+                    return false;
+            }
+            return true;
+        };
+
+        std::queue<CorralNode> open;
+        std::unordered_set<uint64_t> seen;
+        open.push({barrier, player});
+        bool escaped = false;
+        int expanded = 0;
+        while (!open.empty() && !escaped) {
+            if (++expanded > kCorralNodeBudget) {
+                deadlocks.corralBudgetHits++;
+                return false;  // не уложились в бюджет — тупик не доказан
+            }
+            CorralNode n = std::move(open.front());
+            open.pop();
+
+            for (Point b : n.boxes) grid[idx(b)] = 1;
+            cells.clear();
+            cells.push_back(idx(n.player));
+            r[idx(n.player)] = 1;
+            int canonical = idx(n.player);
+            for (size_t head = 0; head < cells.size(); head++) {
+                Point u{cells[head] % W, cells[head] / W};
+                for (Point d : kDirs) {
+                    Point v = u + d;
+                    if (!InBounds(v, H, W))
+                        continue;
+                    int vi = idx(v);
+                    if (level.wall[vi] || grid[vi] || r[vi])
+                        continue;
+                    r[vi] = 1;
+                    canonical = std::min(canonical, vi);
+                    cells.push_back(vi);
+                }
+            }
+
+            uint64_t key = ZobristKey(kZobristPlayer, canonical);
+            for (Point b : n.boxes) key ^= ZobristKey(kZobristBox, idx(b));
+            const bool fresh = seen.insert(key).second;
+            escaped = fresh && success(n);
+            if (fresh && !escaped) {
+                for (size_t i = 0; i < n.boxes.size(); i++) {
+                    Point b = n.boxes[i];
+                    for (Point d : kDirs) {
+                        Point dest = b + d;
+                        Point from = b - d;
+                        if (!InBounds(dest, H, W) || !InBounds(from, H, W))
+                            continue;
+                        int di = idx(dest);
+                        if (level.wall[di] || grid[di] || level.dead[di] || !r[idx(from)])
+                            continue;
+                        CorralNode next = n;
+                        next.boxes[i] = dest;
+                        next.player = b;
+                        open.push(std::move(next));
+                    }
+                }
+            }
+            for (Point b : n.boxes) grid[idx(b)] = 0;
+            for (int c : cells) r[c] = 0;
+        }
+        if (!escaped) {
+            deadlocks.corral++;
+            return true;
+        }
+    }
+    return false;
+}
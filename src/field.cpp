@@ -23,12 +23,11 @@ Field ::Field(std::string fileName) {
     arr = nullptr;
     std::ifstream file(fileName);
     if (!file.is_open()) {
-        std::cout << "file is not open" << std::endl;
+        std::cerr << "file is not open" << std::endl;
         return;
     }
     file >> width;
     file >> height;
-    std::cout << height << " " << width << std::endl;
     arr = new char[height * (width + 1) + 1];  // allocate 2D array with newlines
     std::string line;
     std::getline(file, line);  // skip line
@@ -38,24 +37,18 @@ Field ::Field(std::string fileName) {
     for (int i = 0; i < height; i++) {
         char* dest = &arr[i * (width + 1)];
         std::getline(file, line);  // read line from file
-        std::cout << line << std::endl;
         memcpy(dest, line.c_str(), width);  // copy line
         dest[width] = '\n';                 // add newline
     }
     arr[height * (width + 1)] = 0;  // null terminator
+    FindPlayer();
 }
 
 void SaveFieldToFile(Field& f, const string filename) {
     int width = f.GetWidth();
     int height = f.GetHeight();
     std::ofstream out(filename);
-    out << width << " " << height << endl;
-    for (int y = 0; y < f.GetHeight(); ++y) {
-        for (int x = 0; x < f.GetWidth(); ++x) {
-            out << f.GetCell({x, y});
-        }
-        out << std::endl;
-    }
+    out << width << " " << height << '\n' << f.ToString();  // строки arr уже заканчиваются '\n'
 }
 
 Field::Field(std::stringstream& ss) {
@@ -73,6 +66,17 @@ Field::Field(std::stringstream& ss) {
         dest[width] = '\n';
     }
     arr[height * (width + 1)] = 0;
+    FindPlayer();
+}
+
+Field::Field(int fieldHeight, int fieldWidth) : width(fieldWidth), height(fieldHeight) {
+    arr = new char[height * (width + 1) + 1];
+    for (int i = 0; i < height; i++) {
+        char* dest = &arr[i * (width + 1)];
+        memset(dest, ' ', width);
+        dest[width] = '\n';
+    }
+    arr[height * (width + 1)] = 0;
 }
 
 // copy constructor
@@ -82,6 +86,10 @@ Field::Field(const Field& other) {
     arr = new char[height * (width + 1) + 1];
     memcpy(arr, other.arr, height * (width + 1) + 1);
     game = other.game;
+    player = other.player;
+    boxesOnGoal = other.boxesOnGoal;
+    history = other.history;
+    historyPos = other.historyPos;
 }
 
 // move constructor
@@ -90,7 +98,11 @@ Field::Field(Field&& other) noexcept
     : width(other.width),
       height(other.height),
       arr(other.arr),
-      game(std::move(other.game)) {
+      game(std::move(other.game)),
+      player(other.player),
+      boxesOnGoal(other.boxesOnGoal),
+      history(std::move(other.history)),
+      historyPos(other.historyPos) {
     other.arr = nullptr;
 }
 
@@ -102,6 +114,11 @@ Field& Field::operator=(const Field& other) {
         arr = new char[height * (width + 1) + 1];
         memcpy(arr, other.arr, height * (width + 1) + 1);
         game = other.game;
+        player = other.player;
+        boxesOnGoal = other.boxesOnGoal;
+        history = other.history;
+        historyPos = other.historyPos;
+        dirty.clear();  // поле заменено целиком — его перерисовывают полностью
     }
     return *this;
 }
@@ -113,7 +130,12 @@ Field& Field::operator=(Field&& other) noexcept {
         height = other.height;
         arr = other.arr;
         game = std::move(other.game);
+        player = other.player;
+        boxesOnGoal = other.boxesOnGoal;
+        history = std::move(other.history);
+        historyPos = other.historyPos;
         other.arr = nullptr;  // обнуляем источник
+        dirty.clear();
     }
     return *this;
 }
@@ -144,8 +166,11 @@ void Field::Print() {
               << arr;
 }
 
-// Check win condition: all boxes are placed correctly
+// Check win condition: all boxes are placed correctly.
+// Для своего GameDescriptor — по счётчику из Move, иначе проверяем цели по одной.
 bool Field::HaveWon(const GameDescriptor& g) {
+    if (&g == game.get())
+        return boxesOnGoal == (int)g.boxPlaces.size();
     for (size_t i = 0; i < g.boxPlaces.size(); i++) {
         if (GetCell(g.boxPlaces[i].pos) != std::toupper(g.boxPlaces[i].name))
             return false;
@@ -160,37 +185,110 @@ bool Field::CanMove(Directions d) {
     return IsEmptySpace(lpos + dv) || (IsBox(lpos + dv) && IsEmptySpace(lpos + dv + dv));
 }
 
+// Ход игрока; записывается в журнал, ветка для Redo после него пропадает
 bool Field::Move(Directions d, StepAnim& anim) {
-    if (CanMove(d)) {
-        Point lpos = GetLoaderPosition();
-        Point dv = GetDirectionVector(d);
-
-        // Позиции в пикселях для анимации
-        sf::Vector2f fromPx = cellToPx(lpos.x, lpos.y);
-        sf::Vector2f toPx = cellToPx(lpos.x + dv.x, lpos.y + dv.y);
+    if (!CanMove(d))
+        return false;
+    bool pushed = IsBox(GetLoaderPosition() + GetDirectionVector(d));
+    Apply(d, anim);
+    history.resize(historyPos);
+    history.push_back(uint8_t(int(d) | (pushed ? kPushedFlag : 0)));
+    historyPos++;
+    return true;
+}
 
-        std::optional<sf::Vector2f> boxFrom, boxTo;
-        std::optional<char> boxChar;  // <—
+// Возврат последнего хода за O(1), без анимации: игрок отступает назад, толкнутый ящик — за ним
+bool Field::Undo() {
+    if (historyPos == 0)
+        return false;
+    uint8_t entry = history[--historyPos];
+    Point dv = GetDirectionVector(Directions(entry & 3));
+    Point lpos = player;
+    Point back = lpos - dv;
+    if (entry & kPushedFlag) {
+        Point boxPos = lpos + dv;
+        char box = GetCell(boxPos);
+        char goal = char(std::tolower(box));
+        boxesOnGoal += (GetBackgroundAt(lpos) == goal) - (GetBackgroundAt(boxPos) == goal);
+        GetCell(lpos) = box;
+        GetCell(boxPos) = GetBackgroundAt(boxPos);
+        dirty.push_back(boxPos);
+    } else {
+        GetCell(lpos) = GetBackgroundAt(lpos);
+    }
+    GetCell(back) = 'x';
+    player = back;
+    dirty.push_back(lpos);
+    dirty.push_back(back);
+    return true;
+}
 
-        if (IsBox(lpos + dv)) {
-            Point boxPos = lpos + dv;
-            Point boxDest = boxPos + dv;
-            boxChar = GetCell(boxPos);
-            boxFrom = cellToPx(boxPos.x, boxPos.y);
-            boxTo = cellToPx(boxDest.x, boxDest.y);
+// Повтор отменённого хода — с анимацией, как обычный ход
+bool Field::Redo(StepAnim& anim) {
+    if (historyPos == history.size())
+        return false;
+    Apply(Directions(history[historyPos] & 3), anim);
+    historyPos++;
+    return true;
+}
 
-            GetCell(boxDest) = GetCell(boxPos);
+// Начальное положение из GameDescriptor::startField, без чтения файла. Журнал остаётся —
+// после рестарта все ходы можно повторить через Redo.
+void Field::Restart() {
+    const Field& start = game->startField;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            char& c = GetCell({x, y});
+            char s = start.arr[y * (width + 1) + x];
+            if (c != s) {
+                c = s;
+                dirty.push_back({x, y});
+            }
         }
+    }
+    player = start.player;
+    historyPos = 0;
+    boxesOnGoal = 0;
+    for (const BoxPlace& place : game->boxPlaces) {
+        if (GetCell(place.pos) == std::toupper(place.name))
+            boxesOnGoal++;
+    }
+}
 
-        // перемещаем игрока в данных
-        GetCell(lpos + dv) = 'x';
-        GetCell(lpos) = game->emptyField.GetCell(lpos);
+// Сам ход (CanMove уже проверен): клетки, счётчики и старт анимации
+void Field::Apply(Directions d, StepAnim& anim) {
+    Point lpos = GetLoaderPosition();
+    Point dv = GetDirectionVector(d);
 
-        // старт анимации
-        anim.start(fromPx, toPx, boxFrom, boxTo, boxChar, kStepDuration);
-        return true;
+    // Позиции в пикселях для анимации
+    sf::Vector2f fromPx = cellToPx(lpos.x, lpos.y);
+    sf::Vector2f toPx = cellToPx(lpos.x + dv.x, lpos.y + dv.y);
+
+    std::optional<sf::Vector2f> boxFrom, boxTo;
+    std::optional<char> boxChar;  // <—
+
+    if (IsBox(lpos + dv)) {
+        Point boxPos = lpos + dv;
+        Point boxDest = boxPos + dv;
+        boxChar = GetCell(boxPos);
+        boxFrom = cellToPx(boxPos.x, boxPos.y);
+        boxTo = cellToPx(boxDest.x, boxDest.y);
+
+        GetCell(boxDest) = GetCell(boxPos);
+        dirty.push_back(boxDest);
+        char goal = char(std::tolower(*boxChar));
+        boxesOnGoal += (GetBackgroundAt(boxDest) == goal) - (GetBackgroundAt(boxPos) == goal);
     }
-    return false;
+
+    // перемещаем игрока в данных
+    GetCell(lpos + dv) = 'x';
+    GetCell(lpos) = game->emptyField.GetCell(lpos);
+    player = lpos + dv;
+    dirty.push_back(lpos);
+    dirty.push_back(lpos + dv);
+
+    // старт анимации
+    anim.start(fromPx, toPx, boxFrom, boxTo, boxChar, kStepDuration);
 }
 
 // Check if cell is empty space or box goal
@@ -212,14 +310,13 @@ bool Field::IsBoxPlaced(Point p) {
 }
 
 // Проверка, что у блока (END или MIDDLE) нет запрещённо близко других стен
-bool Field::IsInRestrictedRadius(WallBlock& block, unordered_map<Point, BlockType>& placedBlocks, Point& random_dir, WallCluster& wall) {
+bool Field::IsInRestrictedRadius(WallBlock& block, MapGrid& placedBlocks, Point& random_dir, WallCluster& wall) {
     // cout << "Checking block at " << block.pos.x << "," << block.pos.y
     //      << " type: " << (block.type == BlockType::END ? "END" : "MIDDLE") << endl;
     if (block.type == BlockType::END) {
         array<Point, 5> neighbors = GetNeighborPointsArray(block, random_dir);
         for (const auto& neighbor : neighbors) {
-            auto it = placedBlocks.find(neighbor);
-            if (it != placedBlocks.end() && IsWallType(it->second)) {
+            if (IsWallType(placedBlocks.At(neighbor))) {
                 return false;
             }
         }
@@ -230,7 +327,7 @@ bool Field::IsInRestrictedRadius(WallBlock& block, unordered_map<Point, BlockTyp
     return true;
 }
 
-bool Field::IsMiddleBlockAcceptable(WallBlock& block, unordered_map<Point, BlockType>& placedBlocks, Point& random_dir, WallCluster& wall) {
+bool Field::IsMiddleBlockAcceptable(WallBlock& block, MapGrid& placedBlocks, Point& random_dir, WallCluster& wall) {
     Point perp1, perp2;
     if (random_dir.x != 0) {
         perp1 = {0, 1};
@@ -254,8 +351,7 @@ bool Field::IsMiddleBlockAcceptable(WallBlock& block, unordered_map<Point, Block
             if (isSelf)
                 continue;
 
-            auto it = placedBlocks.find(check);
-            if (it != placedBlocks.end() && IsWallType(it->second)) {
+            if (IsWallType(placedBlocks.At(check))) {
                 // cout << " ❌ Conflict with block at: " << check.x << "," << check.y << endl;
                 return false;
             }
@@ -265,11 +361,11 @@ bool Field::IsMiddleBlockAcceptable(WallBlock& block, unordered_map<Point, Block
 }
 
 // Проверка валидности стены: нет пересечений и нет запрещённой близости
-bool Field::WallCorrect(WallCluster& wall, unordered_map<Point, BlockType>& placedBlocks, Point& random_dir) {
+bool Field::WallCorrect(WallCluster& wall, MapGrid& placedBlocks, Point& random_dir) {
     for (WallBlock& block : wall.blocks) {
         // Проверка на пересечение с уже размещёнными блоками
 
-        if (placedBlocks.count(block.pos)) {
+        if (placedBlocks.At(block.pos) != BlockType::EMPTY) {
             return false;  // столкновение
         }
 
@@ -290,6 +386,8 @@ void Field::Clear() {
         }
         ptr++;
     }
+    player = {-1, -1};
+    boxesOnGoal = 0;
 }
 
 // Get reference to cell at point
@@ -303,17 +401,22 @@ Point Field::GetDirectionVector(Directions d) {
     return p[(int)d];
 }
 
-// Find loader's current position
+// Loader's current position, tracked by Move
 Point Field::GetLoaderPosition() {
-    char* result = strchr(arr, 'x');  // search for loader char
-    if (result == NULL) {
-        std::exit(1);  // error if not found
-    }
+    if (player.x < 0)
+        throw std::runtime_error("Field: no loader on the map");
+    return player;
+}
+
+// Поиск игрока по всей карте — только при загрузке
+void Field::FindPlayer() {
+    player = {-1, -1};
+    char* result = arr != nullptr ? strchr(arr, 'x') : nullptr;  // search for loader char
+    if (result == NULL)
+        return;
     long int pos = result - arr;  // index from start
-    Point p;
-    p.x = pos % (width + 1);  // остаток это x
-    p.y = pos / (width + 1);  // целая часть без дроби это y
-    return p;
+    player.x = pos % (width + 1);  // остаток это x
+    player.y = pos / (width + 1);  // целая часть без дроби это y
 }
 
 array<Point, 5> Field::GetNeighborPointsArray(WallBlock& block, Point& random_dir) {
@@ -342,23 +445,29 @@ array<Point, 8> Field::GetEightDirections() {
     return {{{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {-1, 1}, {1, -1}}};
 }
 
-WallBlock Field::GetRandomAnchor(int SelectedAnchor, unordered_map<Point, BlockType>& placedBlocks) {
-    int current = 0;
-    for (const auto& [pt, type] : placedBlocks) {
-        if (type != BlockType::ANCHOR)
-            continue;
-        if (current == SelectedAnchor) {
-            return {pt, type};
-        }
-        current++;
+WallBlock Field::GetRandomAnchor(int SelectedAnchor, MapGrid& placedBlocks) {
+    const vector<Point>& anchors = placedBlocks.GetAnchors();
+    if (SelectedAnchor >= 0 && SelectedAnchor < (int)anchors.size()) {
+        return {anchors[SelectedAnchor], BlockType::ANCHOR};
     }
 
     // Если якорей нет вообще — это логическая ошибка генерации
     throw std::runtime_error("GetRandomAnchor: no anchors in placedBlocks");
 }
 
+// Новый GameDescriptor — пересчитываем ящики на целях и игрока (клетки могли писать через GetCell)
 void Field::SetGame(std::shared_ptr<GameDescriptor> g) {
     game = g;
+    history.clear();  // новый уровень — журнал с начала
+    historyPos = 0;
+    FindPlayer();
+    boxesOnGoal = 0;
+    if (game == nullptr)
+        return;
+    for (const BoxPlace& place : game->boxPlaces) {
+        if (GetCell(place.pos) == std::toupper(place.name))
+            boxesOnGoal++;
+    }
 }
 
 char Field::GetBackgroundAt(Point p) const {
@@ -378,15 +487,48 @@ void Field::LoadFromGenerator(std::stringstream& ss) {
     height = std::count(s.begin(), s.end(), '\n');
     arr = new char[s.size() + 1];
     strcpy(arr, s.c_str());
+    FindPlayer();
+}
+
+MapGrid::MapGrid(int mapHeight, int mapWidth)
+    : height(mapHeight), width(mapWidth), cells(mapHeight * mapWidth, BlockType::EMPTY), freeCells(mapHeight * mapWidth), freeSlot(mapHeight * mapWidth) {
+    for (int c = 0; c < height * width; c++) {
+        freeCells[c] = c;
+        freeSlot[c] = c;
+    }
+}
+
+void MapGrid::SwapFree(int i, int j) {
+    swap(freeCells[i], freeCells[j]);
+    freeSlot[freeCells[i]] = i;
+    freeSlot[freeCells[j]] = j;
+}
+
+// Запись блока; список свободных клеток обновляется за O(1) (удаление — обменом с последней)
+void MapGrid::Set(Point p, BlockType t) {
+    int c = p.y * width + p.x;
+    BlockType old = cells[c];
+    cells[c] = t;
+    if (t == BlockType::ANCHOR && old != BlockType::ANCHOR) {
+        anchors.push_back(p);
+    }
+    if (old == BlockType::EMPTY && t != BlockType::EMPTY) {
+        SwapFree(freeSlot[c], int(freeCells.size()) - 1);
+        freeCells.pop_back();
+        freeSlot[c] = -1;
+    } else if (old != BlockType::EMPTY && t == BlockType::EMPTY) {
+        freeSlot[c] = int(freeCells.size());
+        freeCells.push_back(c);
+    }
 }
 
 // Создание стартовых блоков — по периметру карты. Все они типа ANCHOR
-unordered_map<Point, BlockType> Field::InitMap(int& mapHeight, int& mapWidth, int& anchorCounter) {
-    unordered_map<Point, BlockType> placedBlocks;
+MapGrid Field::InitMap(int& mapHeight, int& mapWidth, int& anchorCounter) {
+    MapGrid placedBlocks(mapHeight, mapWidth);
     for (int y = 0; y < mapHeight; y++) {
         for (int x = 0; x < mapWidth; x++) {
             if (x == 0 || x == mapWidth - 1 || y == 0 || y == mapHeight - 1) {
-                placedBlocks[{x, y}] = BlockType::ANCHOR;
+                placedBlocks.Set({x, y}, BlockType::ANCHOR);
                 anchorCounter++;
             }
         }
@@ -395,91 +537,59 @@ unordered_map<Point, BlockType> Field::InitMap(int& mapHeight, int& mapWidth, in
 }
 
 // Добавляет готовую стену в вектор всех размещённых блоков
-void Field::AddToPlacedBlocks(WallCluster wall, unordered_map<Point, BlockType>& placedBlocks) {
+void Field::AddToPlacedBlocks(WallCluster wall, MapGrid& placedBlocks) {
     for (auto& b : wall.blocks) {
-        placedBlocks[{b.pos}] = b.type;  // просто добавляем все блоки, включая END и MIDDLE
+        placedBlocks.Set(b.pos, b.type);  // просто добавляем все блоки, включая END и MIDDLE
     }
 }
 
-vector<Point> Field::AddBoxes(unordered_map<Point, BlockType>& placedBlocks, int& mapHeight, int& mapWidth) {
-    random_device rd;
-    mt19937 rng(rd());
-    uniform_int_distribution<> box_dis_y(2, mapHeight - 3);
-    uniform_int_distribution<> box_dis_x(2, mapWidth - 3);
-    vector<Point> boxes;
-    int boxesAdded = 0;
-    while (boxesAdded < 2) {
-        int y = box_dis_y(rng);
-        int x = box_dis_x(rng);
-        Point candidate = {x, y};
-
-        // Если точка свободна — ставим ящик
-        if (placedBlocks.count(candidate) == 0) {
-            placedBlocks[candidate] = BlockType::BOX;
-            cout << "box #" << boxesAdded << " at (" << candidate.x << "," << candidate.y << ")" << endl;
-            boxesAdded++;
-            boxes.push_back(candidate);
-        }
-        // иначе — продолжаем цикл (выбираем новую точку)
-    }
-    return boxes;
-}
-
-Point Field::AddPlayer(unordered_map<Point, BlockType>& placedBlocks, int& mapHeight, int& mapWidth) {
-    random_device rd;
-    mt19937 rng(rd());
-    uniform_int_distribution<> dis_y(1, mapHeight - 2);
-    uniform_int_distribution<> dis_x(1, mapWidth - 2);
-    while (true) {
-        int y = dis_y(rng);
-        int x = dis_x(rng);
-        Point pos = {x, y};
-
-        if (placedBlocks.count(pos) == 0) {
-            placedBlocks[pos] = {BlockType::PLAYER};
-            return pos;
-        }
+// Ящиков столько же, сколько целей; ящик не ставим вплотную к рамке.
+// Если места не хватило, ящиков будет меньше — такую попытку отбросит generator.
+vector<Point> Field::AddBoxes(MapGrid& placedBlocks, int& mapHeight, int& mapWidth, int& boxes, mt19937& rng) {
+    vector<Point> placed;
+    auto inside = [&](Point p) { return p.x >= 2 && p.x <= mapWidth - 3 && p.y >= 2 && p.y <= mapHeight - 3; };
+    while ((int)placed.size() < boxes) {
+        optional<Point> candidate = placedBlocks.RandomFree(rng, inside);
+        if (!candidate)
+            break;
+        placedBlocks.Set(*candidate, BlockType::BOX);
+        placed.push_back(*candidate);
     }
+    return placed;
+}
+
+Point Field::AddPlayer(MapGrid& placedBlocks, int& mapHeight, int& mapWidth, mt19937& rng) {
+    auto inside = [&](Point p) { return p.x >= 1 && p.x <= mapWidth - 2 && p.y >= 1 && p.y <= mapHeight - 2; };
+    optional<Point> pos = placedBlocks.RandomFree(rng, inside);
+    if (!pos)
+        throw std::runtime_error("AddPlayer: no free cell for the player");
+    placedBlocks.Set(*pos, BlockType::PLAYER);
+    return *pos;
 }
 
-vector<Point> Field::AddTarget(unordered_map<Point, BlockType>& placedBlocks, int& mapHeight, int& mapWidth, int& targets) {
-    random_device rd;
-    mt19937 rng(rd());
-    uniform_int_distribution<> dis_y(1, mapHeight - 2);
-    uniform_int_distribution<> dis_x(1, mapWidth - 2);
+vector<Point> Field::AddTarget(MapGrid& placedBlocks, int& mapHeight, int& mapWidth, int& targets, mt19937& rng) {
     array<Point, 8> neighbors = Field::GetEightDirections();
     vector<Point> targetsvector;
-    int targetCounter = 0;
-
-    while (targetCounter < targets) {
-        int y = dis_y(rng);
-        int x = dis_x(rng);
-        Point pos = {x, y};
 
-        // Не должна быть занята ни стеной, ни ящиком
-        auto it = placedBlocks.find(pos);
-
-        if (it != placedBlocks.end())
-            continue;  // занято чем угодно
-
-        // Вокруг не должно быть других целей
-        bool tooClose = false;
+    // Свободная клетка внутри рамки, вокруг не должно быть других целей
+    auto acceptable = [&](Point pos) {
+        if (pos.x < 1 || pos.x > mapWidth - 2 || pos.y < 1 || pos.y > mapHeight - 2)
+            return false;
         for (const auto& dir : neighbors) {
-            Point neighborPos = {pos.x + dir.x, pos.y + dir.y};
-            auto neighbor = placedBlocks.find(neighborPos);
-            if (neighbor != placedBlocks.end() && neighbor->second == BlockType::TARGET) {
-                tooClose = true;
-                break;
-            }
+            if (placedBlocks.At(pos + dir) == BlockType::TARGET)
+                return false;
         }
-        if (tooClose)
-            continue;
+        return true;
+    };
+
+    while ((int)targetsvector.size() < targets) {
+        optional<Point> pos = placedBlocks.RandomFree(rng, acceptable);
+        if (!pos)
+            break;  // места нет — попытку отбросит generator
 
         // Всё ок — добавляем цель
-        placedBlocks[pos] = BlockType::TARGET;
-        cout << "Target #" << targetCounter << " at (" << pos.x << "," << pos.y << ")\n";
-        targetCounter++;
-        targetsvector.push_back(pos);
+        placedBlocks.Set(*pos, BlockType::TARGET);
+        targetsvector.push_back(*pos);
     }
     return targetsvector;
 }
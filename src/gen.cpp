@@ -0,0 +1,155 @@
+// sokoban-gen — пакетная генерация уровней без окна.
+// Уровень с номером i получает зерно seed + i, поэтому любой уровень пакета повторяется
+// запуском с --seed <его зерно> --count 1. Уровни генерируются параллельно (по уровню
+// на поток) и пишутся по мере готовности в формате файла пула — выход можно сразу
+// дописать в levels.pool; решение в заголовке — направления толчков, а не LURD.
+// Номер, зерно и число толчков каждого уровня — в stderr.
+// С --stats после прогона в FILE пишется статистика поисков и генератора (SearchCounters::ToJson).
+//
+// sokoban-gen --seed S --count N [--height H] [--width W] [--targets T] [--clusters C]
+//             [--moves M] [--solver auto|bfs|astar|idastar|parallel|reverse|bidir] [--threads K] [--out FILE]
+//             [--stats FILE]
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../inc/pool.h"
+#include "../inc/prog.h"
+
+static void Usage() {
+    std::cerr << "usage: sokoban-gen --seed S --count N [--height H] [--width W] [--targets T] [--clusters C]\n"
+                 "                   [--moves M] [--solver auto|bfs|astar|idastar|parallel|reverse|bidir] [--threads K] [--out FILE]\n"
+                 "                   [--stats FILE]\n";
+}
+
+static optional<SolverMode> ParseSolver(const std::string& name) {
+    if (name == "auto")
+        return SolverMode::AUTO;
+    if (name == "bfs")
+        return SolverMode::BFS;
+    if (name == "astar")
+        return SolverMode::ASTAR;
+    if (name == "idastar")
+        return SolverMode::IDASTAR;
+    if (name == "parallel")
+        return SolverMode::PARALLEL_BFS;
+    if (name == "reverse")
+        return SolverMode::REVERSE;
+    if (name == "bidir")
+        return SolverMode::BIDIRECTIONAL;
+    return nullopt;
+}
+
+int main(int argc, char* argv[]) {
+    // по умолчанию — параметры игры из main
+    GeneratorParams params{14, 14, 2, 150, 5};
+    uint32_t seed = 0;
+    bool haveSeed = false;
+    long count = 1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    SolverMode solver = SolverMode::AUTO;
+    std::string outName;
+    std::string statsName;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            Usage();
+            return 2;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--seed") {
+                seed = uint32_t(std::stoul(value));
+                haveSeed = true;
+            } else if (arg == "--count") {
+                count = std::stol(value);
+            } else if (arg == "--height") {
+                params.height = std::stoi(value);
+            } else if (arg == "--width") {
+                params.width = std::stoi(value);
+            } else if (arg == "--targets") {
+                params.targets = std::stoi(value);
+            } else if (arg == "--clusters") {
+                params.clusters = std::stoi(value);
+            } else if (arg == "--moves") {
+                params.moves = std::stoi(value);
+            } else if (arg == "--threads") {
+                threads = std::max(1, std::stoi(value));
+            } else if (arg == "--out") {
+                outName = value;
+            } else if (arg == "--stats") {
+                statsName = value;
+            } else if (arg == "--solver") {
+                auto mode = ParseSolver(value);
+                if (!mode) {
+                    Usage();
+                    return 2;
+                }
+                solver = *mode;
+            } else {
+                Usage();
+                return 2;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "bad value for " << arg << ": " << value << std::endl;
+            return 2;
+        }
+    }
+    if (!haveSeed || count <= 0 || params.height < 5 || params.width < 5 || params.targets <= 0 ||
+        params.targets > int(kMaxBoxes)) {
+        Usage();
+        return 2;
+    }
+
+    std::ofstream file;
+    if (!outName.empty()) {
+        file.open(outName, std::ios::app);
+        if (!file) {
+            std::cerr << "cannot open " << outName << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = outName.empty() ? std::cout : file;
+    GetSearchCounters().enabled = !statsName.empty();
+
+    std::atomic<long> next{0};
+    std::atomic<long> failed{0};
+    std::mutex outMutex;
+    auto worker = [&] {
+        for (long i = next++; i < count; i = next++) {
+            const uint32_t levelSeed = seed + uint32_t(i);
+            try {
+                GeneratedMap generated = GenerateLevel(params.height, params.width, params.targets, params.clusters,
+                                                       params.moves, solver, 1, {}, levelSeed);
+                PooledLevel level{params, 0, MapToStringStream(generated.map, params.height, params.width).str(),
+                                  std::move(generated.solution)};
+                level.hash = CanonicalLevelHash(level.text);
+
+                std::lock_guard<std::mutex> lock(outMutex);
+                WritePooledLevel(out, level);
+                out.flush();
+                std::cerr << "level " << i << " seed " << levelSeed << " pushes " << level.solution.size() << std::endl;
+            } catch (const std::exception& e) {
+                failed++;
+                std::lock_guard<std::mutex> lock(outMutex);
+                std::cerr << "level " << i << " seed " << levelSeed << " failed: " << e.what() << std::endl;
+            }
+        }
+    };
+
+    {
+        std::vector<std::jthread> pool;
+        for (unsigned t = 0; t < threads; t++) pool.emplace_back(worker);
+    }
+    if (!statsName.empty() && !(std::ofstream(statsName) << GetSearchCounters().ToJson() << '\n')) {
+        std::cerr << "cannot write " << statsName << std::endl;
+        return 1;
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,193 @@
+#include "../inc/levels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <unordered_set>
+
+// Символы карты в обоих форматах; пол — ' ', '-' и '_'
+static bool IsMapChar(char c) {
+    return std::strchr("#$.@*+ -_ox", c) != nullptr || (c >= 'A' && c < 'A' + kMaxBoxes) ||
+           (c >= 'a' && c < 'a' + kMaxBoxes);
+}
+
+// Строка карты: только символы карты и есть стена — '#' где угодно или 'o' по краям
+// (у карт игры рамка всегда целая, так слова вроде "one" картой не считаются)
+static bool IsMapRow(const std::string& line) {
+    if (line.empty() || !std::all_of(line.begin(), line.end(), IsMapChar))
+        return false;
+    if (line.find('#') != std::string::npos)
+        return true;
+    size_t first = line.find_first_not_of(' ');
+    return first != std::string::npos && line[first] == 'o' && line.back() == 'o';
+}
+
+// Карта из строк; пустой результат — в карте нет игрока или ящиков не столько, сколько целей
+static std::optional<ParsedLevel> ParseRows(const std::vector<std::string>& rows, std::string title) {
+    ParsedLevel level;
+    level.title = std::move(title);
+    level.height = int(rows.size());
+    level.width = 0;
+    for (const auto& row : rows) level.width = std::max(level.width, int(row.size()));
+
+    Map map(level.height, level.width);
+    ReverseMap& rev = level.start.reverseMap;
+    int players = 0;
+    for (int y = 0; y < level.height; y++) {
+        for (int x = 0; x < int(rows[y].size()); x++) {
+            char c = rows[y][x];
+            Point p{x, y};
+            bool box = c == '$' || c == '*' || (c >= 'A' && c < 'A' + kMaxBoxes);
+            bool target = c == '.' || c == '*' || c == '+' || (c >= 'a' && c < 'a' + kMaxBoxes);
+            bool player = c == '@' || c == '+' || c == 'x';
+            if (c == '#' || c == 'o')
+                map.Set(p, BlockType::MIDDLE);
+            if (box) {
+                map.Set(p, BlockType::BOX);
+                rev.boxes.push_back(p);
+                rev.boxLetters.push_back(c >= 'A' && c < 'A' + kMaxBoxes ? char(c - 'A' + 'a') : 0);
+            }
+            if (target) {
+                rev.targets.push_back(p);
+                rev.targetLetters.push_back(c >= 'a' && c < 'a' + kMaxBoxes ? c : 0);
+            }
+            if (player) {
+                rev.player = p;
+                players++;
+            }
+        }
+    }
+    if (players != 1 || rev.boxes.empty() || rev.boxes.size() != rev.targets.size())
+        return std::nullopt;
+    level.start.map = std::move(map);
+    return level;
+}
+
+std::vector<ParsedLevel> ReadLevelCollection(std::istream& in) {
+    std::vector<ParsedLevel> levels;
+    std::vector<std::string> rows;
+    std::string title;
+    std::string line;
+    int lineNo = 0;
+
+    auto flush = [&] {
+        if (rows.empty())
+            return;
+        if (auto level = ParseRows(rows, title))
+            levels.push_back(std::move(*level));
+        else
+            std::cerr << "Skipping level ending at line " << lineNo << ": needs one player and as many boxes as targets" << std::endl;
+        rows.clear();
+        title.clear();
+    };
+
+    while (std::getline(in, line)) {
+        lineNo++;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (IsMapRow(line)) {
+            rows.push_back(line);
+            continue;
+        }
+        flush();
+        size_t first = line.find_first_not_of(" \t;");
+        if (first != std::string::npos)
+            title = line.substr(first);
+    }
+    flush();
+    return levels;
+}
+
+std::optional<std::string> PushesToLurd(const ParsedLevel& level, const std::vector<Directions>& pushes) {
+    const int H = level.height;
+    const int W = level.width;
+    static const std::array<Point, 4> kDelta{{{-1, 0}, {1, 0}, {0, -1}, {0, 1}}};  // по порядку Directions
+    static const char kStep[] = "lrud";
+
+    const ReverseMap& rev = level.start.reverseMap;
+    const std::vector<Point>& boxes = rev.boxes;
+    const std::vector<Point>& targets = rev.targets;
+    auto boxLetter = [&](size_t i) { return i < rev.boxLetters.size() ? rev.boxLetters[i] : char(0); };
+    auto targetLetter = [&](size_t i) { return i < rev.targetLetters.size() ? rev.targetLetters[i] : char(0); };
+    // слот Zobrist ящика: ящики одной буквы взаимозаменяемы, ящики без буквы — тоже
+    auto slot = [&](size_t i) { return boxLetter(i) ? uint32_t(boxLetter(i) - 'a') : kZobristBox; };
+
+    std::vector<uint8_t> wall(H * W, 0);
+    std::vector<uint8_t> box(H * W, 0);  // номер ящика + 1, 0 — пусто
+    for (int y = 0; y < H; y++)
+        for (int x = 0; x < W; x++) wall[y * W + x] = IsWallType(level.start.map.At({x, y}));
+    uint64_t boxHash = 0;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        box[boxes[i].y * W + boxes[i].x] = uint8_t(i + 1);
+        boxHash ^= ZobristKey(slot(i), Cell(boxes[i].y * W + boxes[i].x));
+    }
+    auto open = [&](Point p) { return InBounds(p, H, W) && !wall[p.y * W + p.x] && !box[p.y * W + p.x]; };
+
+    // (шаг, ящики, область игрока), из которых решение уже не доигрывается — без этого
+    // неверный выбор в начале длинной серии одинаковых толчков перебирается экспоненциально
+    std::unordered_set<uint64_t> failed;
+    std::string moves;
+    std::function<bool(size_t, Point)> replay = [&](size_t k, Point player) {
+        if (k == pushes.size()) {
+            for (size_t i = 0; i < targets.size(); i++) {
+                const int on = box[targets[i].y * W + targets[i].x];
+                if (!on || (targetLetter(i) && boxLetter(on - 1) != targetLetter(i)))
+                    return false;
+            }
+            return true;
+        }
+        // обход области игрока с запоминанием шага, которым пришли в клетку
+        std::vector<int8_t> from(H * W, -1);
+        std::vector<Point> queue{player};
+        from[player.y * W + player.x] = 4;
+        Cell top = Cell(player.y * W + player.x);
+        for (size_t head = 0; head < queue.size(); head++) {
+            top = std::min(top, Cell(queue[head].y * W + queue[head].x));
+            for (int d = 0; d < 4; d++) {
+                Point v = queue[head] + kDelta[d];
+                if (open(v) && from[v.y * W + v.x] < 0) {
+                    from[v.y * W + v.x] = int8_t(d);
+                    queue.push_back(v);
+                }
+            }
+        }
+
+        const uint64_t key = (boxHash ^ ZobristKey(kZobristPlayer, top)) * 0x9E3779B97F4A7C15ull + k;
+        if (failed.count(key))
+            return false;
+
+        const int d = int(pushes[k]);
+        const Point delta = kDelta[d];
+        for (int c = 0; c < H * W; c++) {
+            Point b{c % W, c / W};
+            Point back = b - delta;
+            Point dest = b + delta;
+            if (!box[c] || !InBounds(back, H, W) || from[back.y * W + back.x] < 0 || !open(dest))
+                continue;
+
+            std::string walk;
+            for (Point p = back; p != player; p = p - kDelta[from[p.y * W + p.x]]) walk += kStep[from[p.y * W + p.x]];
+            std::reverse(walk.begin(), walk.end());
+            size_t mark = moves.size();
+            moves += walk;
+            moves += char(kStep[d] - 'a' + 'A');
+
+            const uint8_t id = box[c];
+            const uint64_t moved = ZobristKey(slot(id - 1), Cell(c)) ^ ZobristKey(slot(id - 1), Cell(dest.y * W + dest.x));
+            box[c] = 0;
+            box[dest.y * W + dest.x] = id;
+            boxHash ^= moved;
+            if (replay(k + 1, b))
+                return true;
+            boxHash ^= moved;
+            box[dest.y * W + dest.x] = 0;
+            box[c] = id;
+            moves.resize(mark);
+        }
+        failed.insert(key);
+        return false;
+    };
+    if (!replay(0, level.start.reverseMap.player))
+        return std::nullopt;
+    return moves;
+}
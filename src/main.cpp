@@ -1,76 +1,20 @@
 
 #include "../inc/field.h"
+#include "../inc/pool.h"
+#include "../inc/prefetch.h"
+#include "../inc/profiler.h"
 #include "../inc/prog.h"
-
-void DrawField(sf::RenderWindow& window, Field& f, sf::Font& font,
-               bool hidePlayer, std::optional<Point> hideBoxAt = std::nullopt) {
-    for (int y = 0; y < f.GetHeight(); ++y) {
-        for (int x = 0; x < f.GetWidth(); ++x) {
-            char orig = f.GetCell({x, y});
-            const Point p{x, y};
-
-            sf::RectangleShape rect({CELL_SIZE - 2.0f, CELL_SIZE - 2.0f});
-            rect.setPosition(sf::Vector2f(x * CELL_SIZE + 1, y * CELL_SIZE + 1));
-            rect.setFillColor(sf::Color(40, 40, 40));
-
-            bool needText = false;
-            char ch = orig;
-
-            // 1) прятать игрока, если идёт анимация
-            if (hidePlayer && orig == 'x') {
-                ch = f.GetBackgroundAt(p);
-            }
-
-            // 2) прятать ТОЛЬКО тот ящик, который сейчас анимируется
-            if (hideBoxAt && *hideBoxAt == Point{x, y} && orig >= 'A' && orig <= 'Z') {
-                ch = f.GetBackgroundAt(p);
-            }
-
-            switch (ch) {
-                case 'o':
-                    rect.setFillColor(sf::Color(100, 100, 100));
-                    break;  // стена
-                case 'x':
-                    rect.setFillColor(sf::Color::Red);
-                    break;  // игрок (если не скрыли)
-                default:
-                    if (ch >= 'A' && ch <= 'Z') {  // статичные ящики
-                        rect.setFillColor(sf::Color(0, 255, 0));
-                        needText = true;
-                    } else if (ch >= 'a' && ch <= 'z') {  // цели
-                        rect.setFillColor(sf::Color(0, 100, 255));
-                        needText = true;
-                    }
-                    break;
-            }
-
-            window.draw(rect);
-
-            if (needText) {
-                sf::Text label{font};
-                label.setString(std::string(1, ch));
-                label.setCharacterSize(CELL_SIZE * 0.7f);
-                label.setFillColor(sf::Color::Black);
-
-                const float hOff = 2.f, vOff = 8.f;
-                sf::FloatRect b = label.getLocalBounds();
-                label.setPosition({rect.getPosition().x + (CELL_SIZE - b.size.x) / 2 - hOff,
-                                   rect.getPosition().y + (CELL_SIZE - b.size.y) / 2 - vOff});
-                window.draw(label);
-            }
-        }
-    }
-}
+#include "../inc/render.h"
 
 int main() {
     try {
         int height = 14, width = 14, targets = 2, clusters = 150, moves = 5;
-        auto map = generator(height, width, targets, clusters, moves);
-        auto ss = MapToStringStream(map, height, width);
-        Field f(ss);
-        SaveFieldToFile(f, "myfile.txt");
-        auto g = std::make_shared<GameDescriptor>(f);
-        f.SetGame(g);
+        // карты берутся из пула или генерируются в фоне, окно открывается сразу с последней сохранённой картой
+        LevelPool pool("levels.pool");
+        LevelPrefetcher prefetcher({height, width, targets, clusters, moves}, &pool);
+        Field f("myfile.txt");
+        bool waitingForMap = f.GetWidth() == 0 || f.GetHeight() == 0;  // сохранённой карты нет — ждём первую сгенерированную
+        std::shared_ptr<GameDescriptor> g;
         sf::Font font;
         try {
             font = sf::Font("FunnelDisplay-VariableFont_wght.ttf");
@@ -79,13 +23,82 @@ int main() {
             return 1;
         }
 
+        BoardRenderer renderer(font);
+        FrameProfiler profiler(font);  // F3 — оверлей, F4 — последние кадры в frames.csv
+        if (!waitingForMap) {
+            g = std::make_shared<GameDescriptor>(f);
+            f.SetGame(g);
+            renderer.Load(f);
+        }
+
+        // тексты экранов создаются один раз; sf::Text сам кэширует свою геометрию
+        sf::Text waitText(font, "Generating map...", 40);
+        sf::Text pauseText(font, "Pause", 90);
+        sf::Text pauseChooseText(font, "Press R to restart,\n\nESC to continue,\n\nQ to quit", 22);
+        sf::Text winText(font, "You win!", 90);
+        sf::Text winChooseText(font, "Press R to restart,\n\nG to generate new map,\n\nQ to quit", 22);
+        for (sf::Text* text : {&waitText, &pauseText, &pauseChooseText, &winText, &winChooseText}) {
+            text->setFillColor(sf::Color::White);
+        }
+
         StepAnim anim;
         bool showWin = false;
         bool showPause = false;
-        sf::RenderWindow window(sf::VideoMode(sf::Vector2u(width * CELL_SIZE, height * CELL_SIZE)), "Sokoban SFML");
+        sf::Vector2u windowSize(width * CELL_SIZE, height * CELL_SIZE);
+        if (!waitingForMap) {
+            windowSize = sf::Vector2u(f.GetWidth() * CELL_SIZE, f.GetHeight() * CELL_SIZE);
+        }
+        sf::RenderWindow window(sf::VideoMode(windowSize), "Sokoban SFML");
         window.setKeyRepeatEnabled(false);
         window.setVerticalSyncEnabled(true);  // sync to display refresh for smooth animation
+
+        // экраны привязаны к середине окна по высоте
+        auto layoutTexts = [&](sf::Vector2u size) {
+            float middle = size.y / 2.f;
+            waitText.setPosition({110.f, middle - 30.f});
+            pauseText.setPosition({150.f, middle - 130.f});
+            pauseChooseText.setPosition({190.f, middle + 10.f});
+            winText.setPosition({100.f, middle - 70.f});
+            winChooseText.setPosition({160.f, middle + 60.f});
+        };
+        layoutTexts(windowSize);
+
+        // подгоняем окно под размер карты (сохранённая карта могла быть другого размера)
+        auto fitWindow = [&]() {
+            sf::Vector2u size(f.GetWidth() * CELL_SIZE, f.GetHeight() * CELL_SIZE);
+            if (window.getSize() != size) {
+                window.setSize(size);
+                window.setView(sf::View(sf::FloatRect({0.f, 0.f}, sf::Vector2f(size))));
+                layoutTexts(size);
+            }
+        };
+
+        // готовая карта из очереди: без генерации на этом потоке
+        auto loadGenerated = [&](const std::string& text) {
+            std::stringstream ss(text);
+            GenerateNewMap(f, ss);
+            g = std::make_shared<GameDescriptor>(f);
+            f.SetGame(g);
+            renderer.Load(f);
+            SaveFieldToFile(f, "myfile.txt");
+            fitWindow();
+        };
+
+        // тексты экранов — по вызову draw на каждый
+        auto drawText = [&](const sf::Text& text) {
+            window.draw(text);
+            profiler.AddDrawCalls(1);
+        };
+
         while (window.isOpen()) {
+            profiler.BeginFrame();
+            if (waitingForMap) {
+                if (auto text = prefetcher.TryPop()) {
+                    loadGenerated(*text);
+                    waitingForMap = false;
+                }
+            }
+
             while (const std::optional<sf::Event> event = window.pollEvent()) {
                 if (event->is<sf::Event::Closed>()) {
                     window.close();
@@ -97,6 +110,27 @@ int main() {
 
                 const auto* key = event->getIf<sf::Event::KeyPressed>();
 
+                // профилировщик работает на любом экране
+                if (key->code == sf::Keyboard::Key::F3) {
+                    profiler.Toggle();
+                    continue;
+                }
+                if (key->code == sf::Keyboard::Key::F4) {
+                    if (profiler.ExportCsv("frames.csv"))
+                        std::cerr << "Saved " << profiler.Size() << " frames to frames.csv" << std::endl;
+                    else
+                        std::cerr << "Cannot write frames.csv" << std::endl;
+                    continue;
+                }
+
+                // --- WAITING FOR MAP ---
+                if (waitingForMap) {
+                    if (key->code == sf::Keyboard::Key::Q) {
+                        window.close();
+                    }
+                    continue;
+                }
+
                 // --- PAUSE SCREEN ---
                 if (showPause) {
                     switch (key->code) {
@@ -105,9 +139,7 @@ int main() {
                             break;
                         }
                         case (sf::Keyboard::Key::R): {
-                            ReloadMap(f, "myfile.txt");
-                            g = std::make_shared<GameDescriptor>(f);
-                            f.SetGame(g);
+                            f.Restart();  // из памяти, журнал ходов остаётся для Redo
                             showPause = false;
                             break;
                         }
@@ -125,24 +157,18 @@ int main() {
                 if (showWin) {
                     switch (key->code) {
                         case (sf::Keyboard::Key::R): {
-                            ReloadMap(f, "myfile.txt");
-                            g = std::make_shared<GameDescriptor>(f);
-                            f.SetGame(g);
+                            f.Restart();
                             showWin = false;
                             break;
                         }
                         case (sf::Keyboard::Key::G): {
-                            try {
-                                auto newMap = generator(height, width, targets, clusters, moves);
-                                auto ss = MapToStringStream(newMap, height, width);
-                                GenerateNewMap(f, ss);
-                                g = std::make_shared<GameDescriptor>(f);
-                                f.SetGame(g);
-                                SaveFieldToFile(f, "myfile.txt");
-                                showWin = false;
-                            } catch (const std::exception& e) {
-                                std::cerr << "Error generation map: " << e.what() << std::endl;
+                            // карта уже лежит в очереди; если нет — покажем ожидание, пока фон не догонит
+                            if (auto text = prefetcher.TryPop()) {
+                                loadGenerated(*text);
+                            } else {
+                                waitingForMap = true;
                             }
+                            showWin = false;
                             break;
                         }
                         case (sf::Keyboard::Key::Q): {
@@ -181,32 +207,31 @@ int main() {
                     case sf::Keyboard::Key::S:
                         f.Move(Directions::DOWN, anim);
                         break;
+                    case sf::Keyboard::Key::Z:
+                    case sf::Keyboard::Key::Backspace:
+                        f.Undo();
+                        break;
+                    case sf::Keyboard::Key::Y:
+                        f.Redo(anim);
+                        break;
                     default:
                         break;
                 }
             }
-            if (!showWin && f.HaveWon(*g)) {
+            if (!waitingForMap && !showWin && f.HaveWon(*g)) {
                 showWin = true;
             }
+            profiler.Lap(FrameProfiler::Phase::EVENTS);
+
             window.clear(sf::Color::Black);
-            if (showPause) {
-                sf::Text pauseText(font, "Pause", 90);
-                sf::Text chooseText(font, "Press R to restart,\n\nESC to continue,\n\nQ to quit", 22);
-                pauseText.setFillColor(sf::Color::White);
-                chooseText.setFillColor(sf::Color::White);
-                pauseText.setPosition({150.f, window.getSize().y / 2.f - 130.f});
-                chooseText.setPosition({190.f, window.getSize().y / 2.f + 10.f});
-                window.draw(pauseText);
-                window.draw(chooseText);
+            if (waitingForMap) {
+                drawText(waitText);
+            } else if (showPause) {
+                drawText(pauseText);
+                drawText(pauseChooseText);
             } else if (showWin) {
-                sf::Text winText(font, "You win!", 90);
-                sf::Text chooseText(font, "Press R to restart,\n\nG to generate new map,\n\nQ to quit", 22);
-                winText.setFillColor(sf::Color::White);
-                chooseText.setFillColor(sf::Color::White);
-                winText.setPosition({100.f, window.getSize().y / 2.f - 70.f});
-                chooseText.setPosition({160.f, window.getSize().y / 2.f + 60.f});
-                window.draw(winText);
-                window.draw(chooseText);
+                drawText(winText);
+                drawText(winChooseText);
             } else if (!anim.isFinished()) {
                 // Если ящик двигается — спрячем его целевую клетку на карте,
                 // чтобы не было "двойного" ящика (статический + анимируемый)
@@ -214,38 +239,30 @@ int main() {
                 if (anim.BoxTo) {  // именно конечная точка в пикселях
                     hideBox = pxToCell(*anim.BoxTo);
                 }
-                DrawField(window, f, font, /*hidePlayer=*/true, /*hideBoxAt=*/hideBox);
-
-                // игрок (анимация)
-                sf::RectangleShape player({CELL_SIZE - 2.f, CELL_SIZE - 2.f});
-                player.setFillColor(sf::Color::Red);
-                player.setPosition(anim.playerPos());
-                window.draw(player);
+                renderer.Update(f, f.TakeDirty());
+                renderer.Clear();
+                renderer.AddPieces(/*hidePlayer=*/true, /*hideBoxAt=*/hideBox);
 
-                // ящик (анимация)
+                // игрок и ящик (анимация) — отдельным слоем поверх клеток поля
+                renderer.AddMoving(anim.playerPos(), sf::Color::Red);
                 if (auto b = anim.boxPos()) {
-                    sf::RectangleShape box({CELL_SIZE - 2.f, CELL_SIZE - 2.f});
-                    box.setFillColor(sf::Color::Green);
-                    box.setPosition(*b);
-                    window.draw(box);
-
-                    // (опционально) если хочешь букву на анимируемом ящике:
-                    if (anim.boxChar) {  // ← проверка обязательна
-                        sf::Text label{font};
-                        label.setString(std::string(1, *anim.boxChar));
-                        label.setCharacterSize(int(CELL_SIZE * 0.7f));
-                        label.setFillColor(sf::Color::Black);
-                        auto bounds = label.getLocalBounds();
-                        const float hOff = 2.f, vOff = 8.f;
-                        label.setPosition({box.getPosition().x + (CELL_SIZE - bounds.size.x) / 2.f - hOff,
-                                           box.getPosition().y + (CELL_SIZE - bounds.size.y) / 2.f - vOff});
-                        window.draw(label);
-                    }
+                    renderer.AddMoving(*b, sf::Color::Green, anim.boxChar.value_or(0));
                 }
+                renderer.Draw(window);
             } else {
-                DrawField(window, f, font, /*hidePlayer=*/false);
+                renderer.Update(f, f.TakeDirty());
+                renderer.Clear();
+                renderer.AddPieces(/*hidePlayer=*/false);
+                renderer.Draw(window);
             }
+            profiler.AddDrawCalls(renderer.TakeDrawCalls());
+            profiler.Lap(FrameProfiler::Phase::DRAW);
+
+            profiler.Draw(window);
+            profiler.Lap(FrameProfiler::Phase::OVERLAY);
+
             window.display();
+            profiler.Lap(FrameProfiler::Phase::DISPLAY);
         }
         return 0;
     } catch (const std::exception& e) {
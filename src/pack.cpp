@@ -0,0 +1,250 @@
+#include "../inc/pack.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+ParsedLevel PackedLevel::ToParsed() const {
+    ParsedLevel level;
+    level.title = std::string(title);
+    level.height = height;
+    level.width = width;
+    Map map(height, width);
+    ReverseMap& rev = level.start.reverseMap;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            Point p{x, y};
+            switch (At(p)) {
+                case PackCell::WALL:
+                    map.Set(p, BlockType::MIDDLE);
+                    break;
+                case PackCell::BOX_ON_TARGET:
+                    rev.targets.push_back(p);
+                    [[fallthrough]];
+                case PackCell::BOX:
+                    map.Set(p, BlockType::BOX);
+                    rev.boxes.push_back(p);
+                    break;
+                case PackCell::PLAYER_ON_TARGET:
+                    rev.targets.push_back(p);
+                    [[fallthrough]];
+                case PackCell::PLAYER:
+                    rev.player = p;
+                    break;
+                case PackCell::TARGET:
+                    rev.targets.push_back(p);
+                    break;
+                case PackCell::FLOOR:
+                    break;
+            }
+        }
+    }
+    level.start.map = std::move(map);
+
+    // ящики и цели собраны по порядку строк — в том же порядке, что и их буквы в записи
+    const size_t count = letters[0];
+    if (count == 0)
+        return level;
+    if (count != rev.boxes.size() + rev.targets.size())
+        throw std::runtime_error("PackedLevel: letters do not match boxes and targets");
+    for (size_t i = 0; i < count; i++) {
+        const char letter = char(letters[1 + i]);
+        if (letter < 'a' || letter >= 'a' + kMaxBoxes)
+            throw std::runtime_error("PackedLevel: bad box letter");
+        (i < rev.boxes.size() ? rev.boxLetters : rev.targetLetters).push_back(letter);
+    }
+    return level;
+}
+
+Field PackedLevel::ToField() const {
+    const ParsedLevel level = ToParsed();
+    const ReverseMap& rev = level.start.reverseMap;
+    const bool lettered = !rev.boxLetters.empty();
+    Field f(height, width);
+    size_t box = 0;
+    size_t target = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            char& c = f.GetCell({x, y});
+            switch (At({x, y})) {
+                case PackCell::WALL:
+                    c = 'o';
+                    break;
+                case PackCell::BOX:
+                    c = lettered ? char(rev.boxLetters[box] - 'a' + 'A') : char('A' + box);
+                    box++;
+                    break;
+                case PackCell::TARGET:
+                    c = lettered ? rev.targetLetters[target] : char('a' + target);
+                    target++;
+                    break;
+                case PackCell::PLAYER:
+                    c = 'x';
+                    break;
+                case PackCell::FLOOR:
+                    break;
+                default:
+                    throw std::runtime_error("PackedLevel::ToField: box or player on a target");
+            }
+        }
+    }
+    return f;
+}
+
+LevelPack::LevelPack(const std::string& fileName) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open level pack " + fileName);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(PackHeader)) {
+        close(fd);
+        throw std::runtime_error("Level pack " + fileName + " is too short");
+    }
+    size = size_t(st.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // отображение остаётся и без дескриптора
+    if (mapped == MAP_FAILED)
+        throw std::runtime_error("Cannot map level pack " + fileName);
+    data = static_cast<const uint8_t*>(mapped);
+
+    auto damaged = [&] {
+        munmap(const_cast<uint8_t*>(data), size);
+        return std::runtime_error("Level pack " + fileName + " is damaged or has another version");
+    };
+    PackHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kPackMagic, sizeof(kPackMagic)) != 0 || header.version != kPackVersion ||
+        header.indexOffset < sizeof(PackHeader) || header.indexOffset > size ||
+        (size - header.indexOffset) / sizeof(uint64_t) < header.count)
+        throw damaged();
+    count = header.count;
+    index = data + header.indexOffset;
+
+    // каждая запись целиком лежит между заголовком и индексом — дальше PackedLevel читает без проверок
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t offset;
+        std::memcpy(&offset, index + size_t(i) * sizeof(uint64_t), sizeof(offset));
+        if (offset < sizeof(PackHeader) || offset > header.indexOffset || header.indexOffset - offset < 4)
+            throw damaged();
+        const uint8_t* record = data + offset;
+        const size_t room = header.indexOffset - offset;
+        const size_t lettersAt = PackCellsEnd(record[0], record[1], record[2] | record[3] << 8);
+        if (room < lettersAt + 1 || room - lettersAt - 1 < record[lettersAt])
+            throw damaged();
+    }
+}
+
+LevelPack::~LevelPack() {
+    if (data != nullptr)
+        munmap(const_cast<uint8_t*>(data), size);
+}
+
+PackedLevel LevelPack::operator[](size_t i) const {
+    if (i >= count)
+        throw std::out_of_range("LevelPack: level " + std::to_string(i) + " of " + std::to_string(count));
+    uint64_t offset;
+    std::memcpy(&offset, index + i * sizeof(uint64_t), sizeof(offset));
+    return PackedLevel(data + offset);
+}
+
+bool IsLevelPack(const std::string& fileName) {
+    std::ifstream in(fileName, std::ios::binary);
+    char magic[sizeof(kPackMagic)] = {};
+    in.read(magic, sizeof(magic));
+    return in && std::memcmp(magic, kPackMagic, sizeof(kPackMagic)) == 0;
+}
+
+static PackCell CellOf(const ParsedLevel& level, const std::vector<uint8_t>& target, Point p) {
+    const int i = p.y * level.width + p.x;
+    const bool onTarget = target[i];
+    if (level.start.reverseMap.player == p)
+        return onTarget ? PackCell::PLAYER_ON_TARGET : PackCell::PLAYER;
+    BlockType t = level.start.map.At(p);
+    if (t == BlockType::BOX)
+        return onTarget ? PackCell::BOX_ON_TARGET : PackCell::BOX;
+    if (IsWallType(t))
+        return PackCell::WALL;
+    return onTarget ? PackCell::TARGET : PackCell::FLOOR;
+}
+
+void WriteLevelPack(const std::string& fileName, const std::vector<ParsedLevel>& levels) {
+    std::vector<uint8_t> body;
+    std::vector<uint64_t> offsets;
+    for (const auto& level : levels) {
+        const int H = level.height;
+        const int W = level.width;
+        if (H > 255 || W > 255)
+            throw std::runtime_error("WriteLevelPack: level is larger than 255x255");
+        if (level.title.size() > 0xFFFF)
+            throw std::runtime_error("WriteLevelPack: level title is longer than 65535 bytes");
+        offsets.push_back(sizeof(PackHeader) + body.size());
+
+        const ReverseMap& rev = level.start.reverseMap;
+        std::vector<uint8_t> target(H * W, 0);
+        for (Point t : rev.targets) target[t.y * W + t.x] = 1;
+
+        // ещё один байт после клеток — PackedLevel::At читает клетку двумя байтами сразу
+        const size_t titleLength = level.title.size();
+        size_t start = body.size();
+        body.resize(start + PackCellsEnd(H, W, titleLength), 0);
+        body[start] = uint8_t(H);
+        body[start + 1] = uint8_t(W);
+        body[start + 2] = uint8_t(titleLength);
+        body[start + 3] = uint8_t(titleLength >> 8);
+        std::memcpy(&body[start + 4], level.title.data(), titleLength);
+        uint8_t* cells = &body[start + 4 + titleLength];
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                size_t bit = size_t(y * W + x) * 3;
+                unsigned code = unsigned(CellOf(level, target, {x, y})) << (bit % 8);
+                cells[bit / 8] |= uint8_t(code);
+                cells[bit / 8 + 1] |= uint8_t(code >> 8);
+            }
+        }
+
+        // буквы ящиков, потом целей по порядку строк — так PackedLevel::ToParsed собирает ящики и цели
+        const bool lettered = std::any_of(rev.boxLetters.begin(), rev.boxLetters.end(), [](char c) { return c != 0; }) ||
+                              std::any_of(rev.targetLetters.begin(), rev.targetLetters.end(), [](char c) { return c != 0; });
+        std::vector<char> boxLetter(H * W, 0);
+        std::vector<char> targetLetter(H * W, 0);
+        for (size_t i = 0; i < rev.boxes.size(); i++)
+            boxLetter[rev.boxes[i].y * W + rev.boxes[i].x] = i < rev.boxLetters.size() ? rev.boxLetters[i] : 0;
+        for (size_t i = 0; i < rev.targets.size(); i++)
+            targetLetter[rev.targets[i].y * W + rev.targets[i].x] = i < rev.targetLetters.size() ? rev.targetLetters[i] : 0;
+        std::vector<uint8_t> letters;
+        for (int i = 0; lettered && i < H * W; i++) {
+            const PackCell cell = CellOf(level, target, {i % W, i / W});
+            if (cell == PackCell::BOX || cell == PackCell::BOX_ON_TARGET)
+                letters.push_back(uint8_t(boxLetter[i]));
+        }
+        for (int i = 0; lettered && i < H * W; i++) {
+            if (target[i])
+                letters.push_back(uint8_t(targetLetter[i]));
+        }
+        if (std::count(letters.begin(), letters.end(), 0) != 0)
+            throw std::runtime_error("WriteLevelPack: some boxes or targets have no letter");
+        if (letters.size() > 255)
+            throw std::runtime_error("WriteLevelPack: more than 255 letters in a level");
+        body.push_back(uint8_t(letters.size()));
+        body.insert(body.end(), letters.begin(), letters.end());
+    }
+
+    PackHeader header;
+    std::memcpy(header.magic, kPackMagic, sizeof(kPackMagic));
+    header.version = kPackVersion;
+    header.count = uint32_t(levels.size());
+    header.indexOffset = sizeof(PackHeader) + body.size();
+
+    std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(body.data()), std::streamsize(body.size()));
+    out.write(reinterpret_cast<const char*>(offsets.data()), std::streamsize(offsets.size() * sizeof(uint64_t)));
+    if (!out)
+        throw std::runtime_error("Cannot write level pack " + fileName);
+}
@@ -0,0 +1,30 @@
+// sokoban-pack — переводит сборник уровней (XSB, формат игры или файл пула) в двоичный пакет;
+// названия уровней и буквы ящиков и целей формата игры сохраняются.
+//
+// sokoban-pack IN OUT
+#include <fstream>
+#include <iostream>
+
+#include "../inc/levels.h"
+#include "../inc/pack.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "usage: sokoban-pack IN OUT\n";
+        return 2;
+    }
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    try {
+        std::vector<ParsedLevel> levels = ReadLevelCollection(in);
+        WriteLevelPack(argv[2], levels);
+        std::cerr << "Packed " << levels.size() << " levels into " << argv[2] << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
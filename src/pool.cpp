@@ -0,0 +1,170 @@
+#include "../inc/pool.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+
+static const char kDirChars[] = "LRUD";  // по порядку Directions
+
+static std::string SolutionToString(const std::vector<Directions>& solution) {
+    std::string s;
+    for (Directions d : solution) s += kDirChars[(int)d];
+    return s.empty() ? "-" : s;
+}
+
+static std::vector<Directions> SolutionFromString(const std::string& s) {
+    std::vector<Directions> solution;
+    for (char c : s) {
+        const char* p = std::strchr(kDirChars, c);
+        if (p != nullptr)
+            solution.push_back(Directions(p - kDirChars));
+    }
+    return solution;
+}
+
+// Стены, ящики и цели входят в ключ как есть, а игрок — как левая верхняя клетка
+// его области (как в StateKey): одна и та же карта с игроком в другом месте той же
+// области — это тот же уровень.
+uint64_t CanonicalLevelHash(const std::string& text) {
+    std::vector<std::string> rows;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) rows.push_back(line);
+    const int H = rows.size();
+    auto cell = [&](int x, int y) { return x < (int)rows[y].size() ? rows[y][x] : ' '; };
+
+    uint64_t key = 0;
+    Point player{-1, -1};
+    int W = 0;
+    for (int y = 0; y < H; y++) {
+        W = std::max(W, (int)rows[y].size());
+        for (int x = 0; x < (int)rows[y].size(); x++) {
+            char c = rows[y][x];
+            if (c == 'x')
+                player = {x, y};
+            else if (c != ' ')
+                key ^= ZobristKey(uint8_t(c), ZobristCell({x, y}));  // слот — символ клетки
+        }
+    }
+    if (player.x < 0)
+        return key;
+
+    // обход области игрока: проходимы пустые клетки и цели
+    auto open = [&](Point p) {
+        if (!InBounds(p, H, W))
+            return false;
+        char c = cell(p.x, p.y);
+        return c == ' ' || c == 'x' || (c >= 'a' && c < 'o');
+    };
+    std::vector<uint8_t> seen(H * W, 0);
+    std::vector<Point> stack{player};
+    seen[player.y * W + player.x] = 1;
+    Point top = player;
+    while (!stack.empty()) {
+        Point u = stack.back();
+        stack.pop_back();
+        if (u.y < top.y || (u.y == top.y && u.x < top.x))
+            top = u;
+        for (Point d : {Point{1, 0}, Point{-1, 0}, Point{0, 1}, Point{0, -1}}) {
+            Point v = u + d;
+            if (open(v) && !seen[v.y * W + v.x]) {
+                seen[v.y * W + v.x] = 1;
+                stack.push_back(v);
+            }
+        }
+    }
+    return key ^ ZobristKey(kZobristPlayer, ZobristCell(top));
+}
+
+void WritePooledLevel(std::ostream& out, const PooledLevel& level) {
+    out << "level " << level.params.height << ' ' << level.params.width << ' ' << level.params.targets << ' '
+        << level.params.clusters << ' ' << level.params.moves << ' ' << std::hex << level.hash << std::dec << ' '
+        << level.solution.size() << ' ' << SolutionToString(level.solution) << '\n'
+        << level.text;
+}
+
+// Формат файла: заголовок "level H W targets clusters moves hash pushes solution", затем H строк карты.
+// pushes — число толчков, solution — их направления буквами LRUD ('-' у пустого решения).
+// Запись, которая не читается целиком (оборванная запись, мусор), и всё после неё отрезаются
+// от файла: иначе Add дописывал бы новые уровни за мусором, и они бы уже не загрузились.
+LevelPool::LevelPool(std::string name) : fileName(std::move(name)), rng(std::random_device{}()) {
+    std::ifstream in(fileName);
+    std::streamoff good = 0;  // конец последней целой записи
+    bool damaged = false;
+    std::string tag;
+    while (in >> tag) {
+        PooledLevel level;
+        size_t pushes;
+        std::string solution;
+        in >> level.params.height >> level.params.width >> level.params.targets >> level.params.clusters >>
+            level.params.moves >> std::hex >> level.hash >> std::dec >> pushes >> solution;
+        std::string line;
+        std::getline(in, line);  // конец заголовка
+        damaged = tag != "level" || !in || level.params.height <= 0;
+        for (int y = 0; y < level.params.height && !damaged; y++) {
+            // строка карты — ровно width клеток и перевод строки
+            damaged = !std::getline(in, line) || in.eof() || (int)line.size() != level.params.width;
+            level.text += line + '\n';
+        }
+        level.solution = SolutionFromString(solution);
+        damaged = damaged || level.solution.size() != pushes;
+        if (damaged)
+            break;
+        good = in.tellg();
+        Insert(std::move(level));
+    }
+    if (damaged) {
+        in.close();
+        std::error_code error;
+        std::filesystem::resize_file(fileName, good, error);
+        std::cerr << "Level pool " << fileName << " is damaged, loaded " << levels.size() << " levels"
+                  << (error ? ", cannot cut off the rest: " + error.message() : ", the rest is cut off") << std::endl;
+    }
+    for (auto& [params, bucket] : buckets) std::shuffle(bucket.order.begin(), bucket.order.end(), rng);
+}
+
+bool LevelPool::Insert(PooledLevel level) {
+    level.hash = CanonicalLevelHash(level.text);
+    if (!hashes.insert(level.hash).second)
+        return false;
+    buckets[level.params].order.push_back(levels.size());
+    levels.push_back(std::move(level));
+    return true;
+}
+
+std::optional<PooledLevel> LevelPool::Draw(const GeneratorParams& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = buckets.find(params);
+    if (it == buckets.end() || it->second.next == it->second.order.size())
+        return std::nullopt;
+    return levels[it->second.order[it->second.next++]];
+}
+
+// Новый уровень (обычно только что сгенерированный) сразу дописывается в файл.
+// drawn — уровень уже показан игроку, и Draw в этой сессии его не вернёт.
+bool LevelPool::Add(PooledLevel level, bool drawn) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!Insert(level))
+        return false;
+    const PooledLevel& added = levels.back();
+    if (drawn) {
+        Bucket& bucket = buckets[added.params];
+        std::swap(bucket.order[bucket.next], bucket.order.back());
+        bucket.next++;
+    }
+
+    std::ofstream out(fileName, std::ios::app);
+    WritePooledLevel(out, added);
+    return true;
+}
+
+size_t LevelPool::Available(const GeneratorParams& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = buckets.find(params);
+    return it == buckets.end() ? 0 : it->second.order.size() - it->second.next;
+}
+
+size_t LevelPool::Size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return levels.size();
+}
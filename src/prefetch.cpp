@@ -0,0 +1,53 @@
+#include "../inc/prefetch.h"
+
+#include <sstream>
+
+LevelPrefetcher::LevelPrefetcher(GeneratorParams p, LevelPool* levelPool, size_t cap)
+    : params(p), pool(levelPool), capacity(cap), worker([this](std::stop_token stop) { Run(stop); }) {}
+
+void LevelPrefetcher::Run(std::stop_token stop) {
+    // одно ядро оставляем окну, остальные отдаём генератору
+    unsigned cores = std::thread::hardware_concurrency();
+    unsigned threads = cores > 1 ? cores - 1 : 1;
+    while (!stop.stop_requested()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!changed.wait(lock, stop, [this] { return ready.size() < capacity; }))
+                return;  // попросили остановиться
+        }
+        try {
+            std::string text;
+            if (pool != nullptr) {
+                if (auto level = pool->Draw(params))
+                    text = std::move(level->text);
+            }
+            if (text.empty()) {
+                auto generated = GenerateLevel(params.height, params.width, params.targets, params.clusters,
+                                               params.moves, SolverMode::AUTO, threads, stop);
+                text = MapToStringStream(generated.map, params.height, params.width).str();
+                if (pool != nullptr)
+                    pool->Add({params, 0, text, std::move(generated.solution)});
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.push_back(std::move(text));
+        } catch (const std::exception& e) {
+            if (!stop.stop_requested())
+                std::cerr << "Error generation map: " << e.what() << std::endl;
+        }
+    }
+}
+
+std::optional<std::string> LevelPrefetcher::TryPop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ready.empty())
+        return std::nullopt;
+    std::string text = std::move(ready.front());
+    ready.pop_front();
+    changed.notify_all();  // место в очереди освободилось — поток генерирует следующую
+    return text;
+}
+
+size_t LevelPrefetcher::Ready() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ready.size();
+}
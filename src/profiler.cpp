@@ -0,0 +1,103 @@
+#include "../inc/profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+static const char* const kPhaseNames[] = {"events", "draw", "overlay", "display"};
+
+FrameProfiler::FrameProfiler(const sf::Font& font, float budget) : budgetMs(budget), text(font, "", 14) {
+    text.setFillColor(sf::Color::White);
+    text.setPosition({8.f, 6.f});
+    background.setFillColor(sf::Color(0, 0, 0, 190));
+    background.setPosition({0.f, 0.f});
+}
+
+void FrameProfiler::BeginFrame() {
+    Clock::time_point now = Clock::now();
+    if (started) {
+        current.frameMs = std::chrono::duration<float, std::milli>(now - frameStart).count();
+        frames[next] = current;
+        next = (next + 1) % kProfilerFrames;
+        stored = std::min(stored + 1, kProfilerFrames);
+        counted++;
+    }
+    current = Frame{};
+    frameStart = now;
+    lap = now;
+    started = true;
+}
+
+void FrameProfiler::Lap(Phase phase) {
+    Clock::time_point now = Clock::now();
+    current.phaseMs[size_t(phase)] += std::chrono::duration<float, std::milli>(now - lap).count();
+    lap = now;
+}
+
+// Перцентили по буферу, средние по фазам, пропуски vsync: кадр дольше полутора бюджетов
+void FrameProfiler::Refresh() {
+    if (stored == 0) {
+        text.setString("collecting frames...");
+        return;
+    }
+    std::vector<float> times(stored);
+    std::array<double, size_t(Phase::COUNT)> phaseSum{};
+    double drawCalls = 0;
+    size_t missed = 0;
+    for (size_t i = 0; i < stored; i++) {
+        const Frame& fr = At(i);
+        times[i] = fr.frameMs;
+        for (size_t p = 0; p < phaseSum.size(); p++) phaseSum[p] += fr.phaseMs[p];
+        drawCalls += fr.drawCalls;
+        missed += fr.frameMs > budgetMs * 1.5f;
+    }
+    std::sort(times.begin(), times.end());
+    auto percentile = [&](double q) { return times[std::min(stored - 1, size_t(q * stored))]; };
+
+    char line[160];
+    std::string s;
+    std::snprintf(line, sizeof(line), "frame ms  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f\n", percentile(0.5), percentile(0.95),
+                  percentile(0.99), times.back());
+    s += line;
+    std::snprintf(line, sizeof(line), "budget %.1f ms, missed vsync %zu of %zu\n", budgetMs, missed, stored);
+    s += line;
+    s += "avg ms ";
+    for (size_t p = 0; p < phaseSum.size(); p++) {
+        std::snprintf(line, sizeof(line), " %s %.3f", kPhaseNames[p], phaseSum[p] / stored);
+        s += line;
+    }
+    std::snprintf(line, sizeof(line), "\ndraw calls %.1f per frame, last %u\nF3 hide, F4 save frames.csv", drawCalls / stored,
+                  At(stored - 1).drawCalls);
+    s += line;
+    text.setString(s);
+    sf::FloatRect bounds = text.getLocalBounds();
+    background.setSize({bounds.position.x + bounds.size.x + 16.f, bounds.position.y + bounds.size.y + 14.f});
+}
+
+void FrameProfiler::Draw(sf::RenderTarget& target) {
+    if (!visible)
+        return;
+    Clock::time_point now = Clock::now();
+    if (now - lastRefresh >= std::chrono::milliseconds(250)) {
+        Refresh();
+        lastRefresh = now;
+    }
+    target.draw(background);
+    target.draw(text);
+    AddDrawCalls(2);
+}
+
+bool FrameProfiler::ExportCsv(const std::string& fileName) const {
+    std::ofstream out(fileName, std::ios::trunc);
+    out << "frame,frame_ms";
+    for (const char* name : kPhaseNames) out << ',' << name << "_ms";
+    out << ",draw_calls\n";
+    for (size_t i = 0; i < stored; i++) {
+        const Frame& fr = At(i);
+        out << counted - stored + i << ',' << fr.frameMs;
+        for (float ms : fr.phaseMs) out << ',' << ms;
+        out << ',' << fr.drawCalls << '\n';
+    }
+    return bool(out);
+}
@@ -7,15 +7,19 @@
 #include <termios.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <exception>
 #include <iostream>  // std::cout
 #include <iostream>
+#include <mutex>
 #include <random>
 #include <sstream>  // std::stringstream
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_set>
 
 #include "../inc/field.h"
@@ -31,8 +35,7 @@ bool CanMoveMap(Point direction, StateForGenerator& state) {
         return true;
     }
 
-    auto it = state.map.find(next);
-    if (it != state.map.end() && it->second == BlockType::BOX) {
+    if (state.map.At(next) == BlockType::BOX) {
         Point nextnext = next + direction;
         if (IsEmptySpaceMap(state.map, nextnext)) {
             return true;
@@ -42,13 +45,13 @@ bool CanMoveMap(Point direction, StateForGenerator& state) {
     return false;
 }
 
-bool IsEmptySpaceMap(unordered_map<Point, BlockType>& PlacedBlocks, const Point& pos) {
-    auto it = PlacedBlocks.find(pos);
-    return it == PlacedBlocks.end() || it->second == BlockType::TARGET;
+bool IsEmptySpaceMap(Map& PlacedBlocks, const Point& pos) {
+    BlockType t = PlacedBlocks.At(pos);
+    return t == BlockType::EMPTY || t == BlockType::TARGET;
 }
 
-bool IsBoxMap(unordered_map<Point, BlockType>& PlacedBlocks, Point& pos) {
-    return PlacedBlocks[pos] == BlockType::BOX;
+bool IsBoxMap(Map& PlacedBlocks, Point& pos) {
+    return PlacedBlocks.At(pos) == BlockType::BOX;
 }
 
 Directions PointToDirection(Point p) {
@@ -65,9 +68,9 @@ Directions PointToDirection(Point p) {
     throw std::runtime_error("Invalid direction point");
 }
 
-static inline bool isBlocked(const unordered_map<Point, BlockType>& m, Point p) {
-    auto it = m.find(p);
-    return it != m.end() && (IsWallType(it->second) || it->second == BlockType::BOX);
+static inline bool isBlocked(const Map& m, Point p) {
+    BlockType t = m.At(p);
+    return IsWallType(t) || t == BlockType::BOX;
 }
 
 // Возвращаем true, если ход применён (игрок сдвинулся / толкнул ящик)
@@ -75,26 +78,26 @@ bool MoveMap(Point dir, StateForGenerator& s) {
     Point cur = s.reverseMap.player;
     Point next = cur + dir;
 
-    auto it = s.map.find(next);
+    BlockType t = s.map.At(next);
 
     // Пусто (в т.ч. цель — целей в map нет) → просто идём
-    if (it == s.map.end()) {
+    if (t == BlockType::EMPTY) {
         s.reverseMap.player = next;
         return true;
     }
 
     // Стена — стоп
-    if (IsWallType(it->second))
+    if (IsWallType(t))
         return false;
 
     // Ящик — пробуем толкнуть
-    if (it->second == BlockType::BOX) {
+    if (t == BlockType::BOX) {
         Point nn = next + dir;
         if (isBlocked(s.map, nn))
             return false;  // за ящиком стена/ящик → нельзя
         // сдвигаем ящик next → nn
-        s.map.erase(next);
-        s.map[nn] = BlockType::BOX;
+        s.map.Set(next, BlockType::EMPTY);
+        s.map.Set(nn, BlockType::BOX);
 
         // обновляем список ящиков в reverseMap
         for (auto& b : s.reverseMap.boxes)
@@ -111,28 +114,34 @@ bool MoveMap(Point dir, StateForGenerator& s) {
     return false;  // на всякий случай
 }
 
-ReverseMap BuildReverseMap(const std::unordered_map<Point, BlockType>& map) {
+ReverseMap BuildReverseMap(const Map& map) {
     ReverseMap rev;
-    for (const auto& [pt, type] : map) {
-        switch (type) {
-            case BlockType::PLAYER:
-                rev.player = pt;
-                break;
-            case BlockType::TARGET:
-                rev.targets.push_back(pt);
-                break;
-            case BlockType::BOX:
-                rev.boxes.push_back(pt);
-                break;
-            default:
-                break;
+    Point pt;
+    for (pt.y = 0; pt.y < map.GetHeight(); pt.y++) {
+        for (pt.x = 0; pt.x < map.GetWidth(); pt.x++) {
+            switch (map.At(pt)) {
+                case BlockType::PLAYER:
+                    rev.player = pt;
+                    break;
+                case BlockType::TARGET:
+                    rev.targets.push_back(pt);
+                    break;
+                case BlockType::BOX:
+                    rev.boxes.push_back(pt);
+                    break;
+                default:
+                    break;
+            }
         }
     }
     return rev;
 }
 
 // Constructor: store initial box places
-GameDescriptor::GameDescriptor(Field& field) : emptyField(field) {
+GameDescriptor::GameDescriptor(Field& field) : emptyField(field), startField(field) {
+    // копиям не нужен прежний GameDescriptor поля — иначе каждый уровень держал бы предыдущий
+    emptyField.SetGame(nullptr);
+    startField.SetGame(nullptr);
     emptyField.Clear();  // clear field of boxes and loader
     Point p;
     for (p.x = 0; p.x < emptyField.GetWidth(); p.x++) {
@@ -177,83 +186,264 @@ std::ostream& operator<<(std::ostream& os, Point p) {
     return os << "(" << p.x << ", " << p.y << ")";
 }
 
-unordered_map<Point, BlockType> generator(int H, int W, int targets, int numClusters, int movesQuantity) {
-    int attempt = 0;
-    const int maxAttempts = 1000;
-    std::mt19937 rng(std::random_device{}());
+// Рамка и numClusters случайных стен от якорей
+MapGrid PlaceWalls(int H, int W, int numClusters, std::mt19937& rng) {
     Point directions[4] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
-
-    while (attempt++ < maxAttempts) {
-        int anchorCounter = 0;
-        auto placedBlocks = Field::InitMap(H, W, anchorCounter);
-        ReverseMap rev;
-
-        // стены
-        for (int c = 0; c < numClusters; ++c) {
-            std::uniform_int_distribution<> anchor_dis(0, anchorCounter - 1);
-            WallBlock a = Field::GetRandomAnchor(anchor_dis(rng), placedBlocks);
-            std::uniform_int_distribution<> dir_dis(0, 3);
-            Point dir = directions[dir_dis(rng)];
-            std::uniform_int_distribution<> cluster_dis(2, 6);
-            int cnt = cluster_dis(rng);
-
-            WallCluster wall;
-            for (int i = 1; i < cnt; ++i) {
-                Point b{a.pos.x + i * dir.x, a.pos.y + i * dir.y};
-                if (b.x <= 0 || b.x >= W - 1 || b.y <= 0 || b.y >= H - 1)
-                    continue;
-                BlockType t = (i == cnt - 1) ? BlockType::END : BlockType::MIDDLE;
-                wall.blocks.push_back({b, t});
-            }
-            if (Field::WallCorrect(wall, placedBlocks, dir)) {
-                Field::AddToPlacedBlocks(wall, placedBlocks);
-            }
+    int anchorCounter = 0;
+    auto placedBlocks = Field::InitMap(H, W, anchorCounter);
+
+    for (int c = 0; c < numClusters; ++c) {
+        std::uniform_int_distribution<> anchor_dis(0, anchorCounter - 1);
+        WallBlock a = Field::GetRandomAnchor(anchor_dis(rng), placedBlocks);
+        std::uniform_int_distribution<> dir_dis(0, 3);
+        Point dir = directions[dir_dis(rng)];
+        std::uniform_int_distribution<> cluster_dis(2, 6);
+        int cnt = cluster_dis(rng);
+
+        WallCluster wall;
+        for (int i = 1; i < cnt; ++i) {
+            Point b{a.pos.x + i * dir.x, a.pos.y + i * dir.y};
+            if (b.x <= 0 || b.x >= W - 1 || b.y <= 0 || b.y >= H - 1)
+                continue;
+            BlockType t = (i == cnt - 1) ? BlockType::END : BlockType::MIDDLE;
+            wall.blocks.push_back({b, t});
+        }
+        if (Field::WallCorrect(wall, placedBlocks, dir)) {
+            Field::AddToPlacedBlocks(wall, placedBlocks);
         }
+    }
+    return placedBlocks;
+}
 
-        // объекты
-        rev.boxes = Field::AddBoxes(placedBlocks, H, W);
-        rev.player = Field::AddPlayer(placedBlocks, H, W);
-        rev.targets = Field::AddTarget(placedBlocks, H, W, targets);
+// Время фазы генератора в счётчик sink; при выключенной статистике часы не читаются
+class PhaseTimer {
+   private:
+    atomic<uint64_t>* sink;
+    std::chrono::steady_clock::time_point t0;
+
+   public:
+    explicit PhaseTimer(atomic<uint64_t>& counter)
+        : sink(GetSearchCounters().enabled.load(std::memory_order_relaxed) ? &counter : nullptr) {
+        if (sink)
+            t0 = std::chrono::steady_clock::now();
+    }
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+    ~PhaseTimer() {
+        if (sink)
+            *sink += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+    }
+};
 
-        // Сохраняем карту ДЛЯ ИГРЫ (со всеми объектами)
-        auto gameMap = placedBlocks;
+// Исход попытки генератора
+static void CountAttempt(atomic<uint64_t>& outcome) {
+    if (GetSearchCounters().enabled.load(std::memory_order_relaxed))
+        outcome++;
+}
 
-        // А вот ДЛЯ BFS чистим игрока и цели
-        auto solidMap = placedBlocks;
-        solidMap.erase(rev.player);
-        for (const auto& t : rev.targets) solidMap.erase(t);
+// Обратная попытка: ящики стоят на целях, обратный поиск тягами уводит их как можно дальше.
+// Уровень решаем по построению, а число толчков известно из глубины поиска.
+static optional<GeneratedMap> ReverseAttempt(int H, int W, int targets, int numClusters, int movesQuantity,
+                                             std::mt19937& rng, std::stop_token stop) {
+    SearchCounters& stats = GetSearchCounters();
+    Map placedBlocks;
+    {
+        PhaseTimer timer(stats.wallsNs);
+        placedBlocks = PlaceWalls(H, W, numClusters, rng);
+    }
+    ReverseMap rev;
+    {
+        PhaseTimer timer(stats.objectsNs);
+        rev.targets = Field::AddTarget(placedBlocks, H, W, targets, rng);
+    }
+    if ((int)rev.targets.size() != targets) {
+        CountAttempt(stats.rejectedNoRoom);
+        return nullopt;  // на карте не хватило места под цели
+    }
+    rev.boxes = rev.targets;
+    rev.player = rev.targets[0];  // FarthestPullState перебирает все области сам
 
-        StateForGenerator start{solidMap, rev, {}};
+    auto goalMap = placedBlocks;
+    for (const auto& t : rev.targets) goalMap.Set(t, BlockType::BOX);
 
-        StateForGenerator solved = BFSGenerated(start, H, W);
-        if (!HaveWonMap(solved)) {
-            std::cout << "No solution found on attempt " << attempt << "\n";
-            continue;
-        }
+    StateForGenerator far;
+    {
+        PhaseTimer timer(stats.searchNs);
+        far = FarthestPullState({goalMap, rev, {}}, H, W, kAStarNodeBudget, stop);
+    }
+    if (stop.stop_requested()) {
+        CountAttempt(stats.cancelled);
+        return nullopt;  // другой поток уже нашёл карту
+    }
+    if (far.movesHistory.size() < static_cast<size_t>(movesQuantity)) {
+        CountAttempt(stats.rejectedTooShort);
+        return nullopt;
+    }
+    CountAttempt(stats.accepted);
 
-        // фильтр по минимальному числу толчков (мы пишем их в movesHistory в GenerateNeighbors)
-        if (solved.movesHistory.size() >= static_cast<size_t>(movesQuantity)) {
-            // ВАЖНО: вернуть ИГРОВУЮ карту (с игроком и целями), иначе игра сразу «выиграна»
-            return gameMap;
-        }
+    // игровая карта: стены и цели + найденные ящики и игрок
+    auto gameMap = placedBlocks;
+    for (const auto& b : far.reverseMap.boxes) gameMap.Set(b, BlockType::BOX);
+    gameMap.Set(far.reverseMap.player, BlockType::PLAYER);
+    return GeneratedMap{std::move(gameMap), std::move(far.movesHistory)};
+}
+
+// Одна попытка генерации: стены, объекты и проверка поиском.
+// Пустой результат — карта не подошла (нет решения, слишком короткая или попытку отменили).
+static optional<GeneratedMap> GenerateAttempt(int H, int W, int targets, int numClusters, int movesQuantity, SolverMode solver,
+                                     std::mt19937& rng, std::stop_token stop) {
+    if (solver == SolverMode::REVERSE)
+        return ReverseAttempt(H, W, targets, numClusters, movesQuantity, rng, stop);
+
+    SearchCounters& stats = GetSearchCounters();
+    Map placedBlocks;
+    {
+        PhaseTimer timer(stats.wallsNs);
+        placedBlocks = PlaceWalls(H, W, numClusters, rng);
     }
+    ReverseMap rev;
 
+    // объекты
+    {
+        PhaseTimer timer(stats.objectsNs);
+        rev.boxes = Field::AddBoxes(placedBlocks, H, W, targets, rng);
+        rev.player = Field::AddPlayer(placedBlocks, H, W, rng);
+        rev.targets = Field::AddTarget(placedBlocks, H, W, targets, rng);
+    }
+    if ((int)rev.boxes.size() != targets || (int)rev.targets.size() != targets) {
+        CountAttempt(stats.rejectedNoRoom);
+        return nullopt;  // на карте не хватило места под ящики или цели
+    }
+
+    // Сохраняем карту ДЛЯ ИГРЫ (со всеми объектами)
+    auto gameMap = placedBlocks;
+
+    // А вот ДЛЯ BFS чистим игрока и цели
+    auto solidMap = placedBlocks;
+    solidMap.Set(rev.player, BlockType::EMPTY);
+    for (const auto& t : rev.targets) solidMap.Set(t, BlockType::EMPTY);
+
+    StateForGenerator start{solidMap, rev, {}};
+
+    StateForGenerator solved;
+    {
+        PhaseTimer timer(stats.searchNs);
+        solved = SolveGenerated(start, H, W, solver, stop);
+    }
+    if (stop.stop_requested()) {
+        CountAttempt(stats.cancelled);
+        return nullopt;  // другой поток уже нашёл карту
+    }
+    if (!HaveWonMap(solved)) {
+        CountAttempt(stats.rejectedUnsolvable);
+        return nullopt;
+    }
+
+    // фильтр по минимальному числу толчков (мы пишем их в movesHistory в GenerateNeighbors)
+    if (solved.movesHistory.size() >= static_cast<size_t>(movesQuantity)) {
+        CountAttempt(stats.accepted);
+        // ВАЖНО: вернуть ИГРОВУЮ карту (с игроком и целями), иначе игра сразу «выиграна»
+        return GeneratedMap{std::move(gameMap), std::move(solved.movesHistory)};
+    }
+    CountAttempt(stats.rejectedTooShort);
+    return nullopt;
+}
+
+// Попытки разбираются потоками из общего счётчика. Каждая попытка берёт свой mt19937,
+// засеянный общим зерном и номером попытки, поэтому карта попытки не зависит от потока.
+// Результат — принятая попытка с наименьшим номером: найдя её, поток останавливает только
+// тех, кто занят попытками с большими номерами, меньшие дорабатывают. Так с одним и тем же
+// seed получается одна и та же карта при любом числе потоков.
+// Внешний stop (например, фоновая подготовка карт при выходе из игры) прерывает всё сразу.
+GeneratedMap GenerateLevel(int H, int W, int targets, int numClusters, int movesQuantity, SolverMode solver, unsigned threads, std::stop_token stop, optional<uint32_t> seed) {
+    const int maxAttempts = 1000;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const uint32_t baseSeed = seed ? *seed : std::random_device{}();
+    PhaseTimer timer(GetSearchCounters().generateNs);
+    std::atomic<int> nextAttempt{0};
+    std::vector<std::stop_source> workerStops(threads);
+    std::vector<int> current(threads, 0);  // номер попытки, над которой работает поток (под resultMutex)
+    std::stop_callback forwardStop(stop, [&] {
+        for (auto& s : workerStops) s.request_stop();
+    });
+    std::mutex resultMutex;
+    optional<GeneratedMap> result;
+    int resultAttempt = maxAttempts + 1;
+    std::exception_ptr error;
+
+    auto worker = [&](unsigned index) {
+        std::stop_token workerStop = workerStops[index].get_token();
+        try {
+            while (!workerStop.stop_requested()) {
+                int attempt = ++nextAttempt;
+                {
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    if (attempt > resultAttempt || attempt > maxAttempts)
+                        return;  // меньшая попытка уже принята
+                    current[index] = attempt;
+                }
+                CountAttempt(GetSearchCounters().attempts);
+                std::seed_seq seq{baseSeed, uint32_t(attempt)};
+                std::mt19937 rng(seq);
+                optional<GeneratedMap> map = GenerateAttempt(H, W, targets, numClusters, movesQuantity, solver, rng, workerStop);
+                if (map && !workerStop.stop_requested()) {
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    if (attempt < resultAttempt) {
+                        result = std::move(map);
+                        resultAttempt = attempt;
+                    }
+                    for (unsigned i = 0; i < threads; i++) {
+                        if (current[i] > resultAttempt)
+                            workerStops[i].request_stop();
+                    }
+                    return;
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (!error)
+                error = std::current_exception();
+            for (auto& s : workerStops) s.request_stop();
+        }
+    };
+
+    if (threads == 1) {
+        worker(0);
+    } else {
+        std::vector<std::jthread> pool;
+        for (unsigned i = 0; i < threads; i++) pool.emplace_back(worker, i);
+    }  // jthread дожидается потоков в деструкторе
+
+    if (result) {
+        CountAttempt(GetSearchCounters().levels);
+        return std::move(*result);
+    }
+    if (error)
+        std::rethrow_exception(error);
+    if (stop.stop_requested())
+        throw std::runtime_error("generation cancelled");
     throw std::runtime_error("❌ Could not generate solvable map after max attempts");
 }
 
+Map generator(int H, int W, int targets, int numClusters, int movesQuantity, SolverMode solver, unsigned threads, std::stop_token stop) {
+    return GenerateLevel(H, W, targets, numClusters, movesQuantity, solver, threads, stop).map;
+}
+
 //___________________________________________________________________________________________________________________________________________
 //___________________________________________________________________________________________________________________________________________
 
-stringstream MapToStringStream(unordered_map<Point, BlockType>& placedBlocks, int& mapHeight, int& mapWidth) {
+stringstream MapToStringStream(Map& placedBlocks, int& mapHeight, int& mapWidth) {
     stringstream ss;
     int targetCounter = 0;
     int boxCounter = 0;
     for (int y = 0; y < mapHeight; y++) {
         for (int x = 0; x < mapWidth; x++) {
             char ch = ' ';
-            auto it = placedBlocks.find({x, y});
-            if (it != placedBlocks.end()) {
-                switch (it->second) {
+            BlockType t = placedBlocks.At({x, y});
+            if (t != BlockType::EMPTY) {
+                switch (t) {
                     case BlockType::ANCHOR:
                         ch = 'o';
                         break;
@@ -289,6 +479,8 @@ stringstream MapToStringStream(unordered_map<Point, BlockType>& placedBlocks, in
 }
 
 bool HaveWonMap(const StateForGenerator& s) {
+    if (s.reverseMap.boxes.empty())
+        return false;  // пустое состояние — так поиски сообщают, что решения нет или они сдались
     std::unordered_set<Point> boxSet(s.reverseMap.boxes.begin(), s.reverseMap.boxes.end());
     if (boxSet.size() != s.reverseMap.targets.size())
         return false;
@@ -296,109 +488,161 @@ bool HaveWonMap(const StateForGenerator& s) {
         if (!boxSet.count(t))
             return false;
     }
+    const ReverseMap& rev = s.reverseMap;
+    for (size_t i = 0; i < rev.targets.size() && i < rev.targetLetters.size(); i++) {
+        if (!rev.targetLetters[i])
+            continue;
+        auto on = std::find(rev.boxes.begin(), rev.boxes.end(), rev.targets[i]);
+        const size_t box = size_t(on - rev.boxes.begin());
+        if (box >= rev.boxLetters.size() || rev.boxLetters[box] != rev.targetLetters[i])
+            return false;
+    }
     return true;
 }
 
+SearchCounters& GetSearchCounters() {
+    static SearchCounters counters;
+    return counters;
+}
+
+void SearchCounters::Reset() {
+    for (auto* c : {&searches, &expanded, &generated, &duplicates, &peakVisited, &peakQueue, &gaveUp, &astarFallbacks, &deadSimple, &deadFreeze, &deadCorral,
+                    &freezeBudgetHits, &corralBudgetHits, &levels, &generateNs, &wallsNs,
+                    &objectsNs, &searchNs, &attempts, &accepted, &rejectedNoRoom, &rejectedUnsolvable, &rejectedTooShort,
+                    &cancelled})
+        *c = 0;
+}
+
+// Одна строка JSON; время — в миллисекундах
+string SearchCounters::ToJson() const {
+    auto ms = [](const atomic<uint64_t>& ns) { return double(ns) / 1e6; };
+    std::ostringstream os;
+    os << "{\"search\":{\"searches\":" << searches << ",\"expanded\":" << expanded << ",\"generated\":" << generated
+       << ",\"duplicates\":" << duplicates << ",\"peak_visited\":" << peakVisited << ",\"peak_queue\":" << peakQueue
+       << ",\"gave_up\":" << gaveUp << ",\"astar_fallbacks\":" << astarFallbacks
+       << ",\"deadlocks\":{\"simple\":" << deadSimple << ",\"freeze\":" << deadFreeze << ",\"corral\":" << deadCorral
+       << ",\"freeze_budget_hits\":" << freezeBudgetHits << ",\"corral_budget_hits\":" << corralBudgetHits
+       << "}},\"generator\":{\"levels\":" << levels << ",\"ms\":" << ms(generateNs) << ",\"attempts\":" << attempts
+       << ",\"accepted\":" << accepted << ",\"rejected\":{\"no_room\":" << rejectedNoRoom
+       << ",\"unsolvable\":" << rejectedUnsolvable << ",\"too_short\":" << rejectedTooShort
+       << "},\"cancelled\":" << cancelled << ",\"phase_ms\":{\"walls\":" << ms(wallsNs) << ",\"objects\":" << ms(objectsNs)
+       << ",\"search\":" << ms(searchNs) << "}}}";
+    return os.str();
+}
+
+void SearchTally::Publish() const {
+    SearchCounters& c = GetSearchCounters();
+    if (!c.enabled.load(std::memory_order_relaxed))
+        return;
+    auto raise = [](atomic<uint64_t>& peak, uint64_t v) {
+        uint64_t cur = peak;
+        while (cur < v && !peak.compare_exchange_weak(cur, v)) {
+        }
+    };
+    c.searches++;
+    c.expanded += expanded;
+    c.generated += generated;
+    c.duplicates += duplicates;
+    raise(c.peakVisited, peakVisited);
+    raise(c.peakQueue, peakQueue);
+    if (gaveUp)
+        c.gaveUp++;
+    c.deadSimple += deadlocks.simple;
+    c.deadFreeze += deadlocks.freeze;
+    c.deadCorral += deadlocks.corral;
+    c.freezeBudgetHits += deadlocks.freezeBudgetHits;
+    c.corralBudgetHits += deadlocks.corralBudgetHits;
+}
+
 AI::AI(std::shared_ptr<GameDescriptor> g, Field& f)
-    : game(g), initialState{f, {}} {
-    initialState.field.SetGame(g);
+    : game(g), initialField(f), board(g->emptyField) {
+    initialField.SetGame(g);
+    initialState = board.MakeState(initialField);
 }
 
-vector<State> AI::GenerateNeighbors(State& current, StepAnim& anim) {
-    // making a vector neghbors for next vertexes
-    vector<State> neighbors;
+int AI::GenerateNeighbors(const State& current, uint32_t index, array<State, 4>& next) const {
+    // соседи пишутся в массив вызывающего — никаких аллокаций на узел
+    int count = 0;
     for (Directions d : {Directions::UP, Directions::DOWN, Directions::LEFT, Directions::RIGHT}) {
-        // if in current field in this direction able to move then we add this direction to next field and save it to moves history
-        if (current.field.CanMove(d)) {
-            State next = current;
-            next.field.Move(d, anim);
-            next.movesHistory.push_back(d);
-            neighbors.push_back(next);
+        next[count] = {current.board, index, d, current.key};
+        if (board.TryMove(next[count].board, d, next[count].key)) {
+            count++;
         }
     }
-    return neighbors;
+    return count;
 }
 
-void AI::BFS(Field& f, StepAnim& anim) {
-    queue<State> q;  // queue using for FIFO method which means that the object which was inserted earlier will be used earlier as well
-    // here we using it for detecting all states and choosing in the end only those who leads us to win
-    set<std::string> visited;  // set using for keeping only unique fields
-    q.push(initialState);      //
-    vector<State> neighbors;
-    while (!q.empty()) {
-        State current = q.front();
-        q.pop();
-        if (current.field.HaveWon(*game)) {
-            f = current.field;
-            cout << "SOLUTION TO WIN" << endl;
-            cout << endl;
-            for (auto b : current.movesHistory) {
-                if (b == Directions::LEFT) {
-                    cout << "left" << endl;
-                }
-                if (b == Directions::RIGHT) {
-                    cout << "right" << endl;
-                }
-                if (b == Directions::UP) {
-                    cout << "up" << endl;
-                }
-                if (b == Directions::DOWN) {
-                    cout << "down" << endl;
-                }
-            }
-            return;
-        }
-        for (State next : GenerateNeighbors(current, anim)) {
-            if (!visited.count(next.field.ToString())) {
-                visited.insert(next.field.ToString());
-                q.push(next);
+optional<vector<Directions>> AI::Solve(size_t memBytes) const {
+    // узлы лежат в одном векторе, он же служит очередью FIFO: head — следующий к раскрытию
+    vector<State> nodes;
+    TranspositionTable visited(SearchTableBytes(memBytes, sizeof(State)));  // ключи встреченных состояний и номера узлов
+    uint64_t startKey = board.Hash(initialState);
+    nodes.push_back({initialState, 0, Directions::UP, startKey});
+    visited.Insert(startKey, 0);
+    array<State, 4> next;
+    SearchTally tally;
+    for (size_t head = 0; head < nodes.size(); head++) {
+        tally.Queue(nodes.size() - head);
+        if (board.IsSolved(nodes[head].board)) {
+            tally.expanded = head + 1;
+            tally.peakVisited = visited.Size();
+            tally.Publish();
+            // восстанавливаем путь по ссылкам на родителей
+            vector<Directions> path;
+            for (size_t i = head; i != 0; i = nodes[i].parent) {
+                path.push_back(nodes[i].move);
             }
+            reverse(path.begin(), path.end());
+            return path;
         }
-    }
-    cout << "No solution found." << endl;
-}
-
-std::string SerializeMapForHash(const std::unordered_map<Point, BlockType>& map, int H, int W) {
-    std::string result;
-    result.reserve(H * W + H);
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            auto it = map.find({x, y});
-            char c = '0';  // пусто
-            if (it != map.end()) {
-                if (it->second == BlockType::BOX)
-                    c = 'B';
-                else if (IsWallType(it->second))
-                    c = 'W';
-                else
-                    c = '0';  // игнорируем PLAYER/TARGET и т.п.
+        int count = GenerateNeighbors(nodes[head], uint32_t(head), next);
+        tally.generated += count;
+        for (int i = 0; i < count; i++) {
+            TableInsert r = visited.Insert(next[i].key, uint32_t(nodes.size()));
+            if (r == TableInsert::INSERTED) {
+                nodes.push_back(next[i]);
+            } else if (r == TableInsert::FOUND) {
+                tally.duplicates++;
+            } else {
+                tally.expanded = head + 1;  // таблица заполнена — сдаёмся
+                tally.peakVisited = visited.Size();
+                tally.gaveUp = true;
+                tally.Publish();
+                return nullopt;
             }
-            result.push_back(c);
         }
-        result.push_back('\n');
     }
-    return result;
-}
-
-std::string SerializeState(const StateForGenerator& s, int H, int W) {
-    std::string key = SerializeMapForHash(s.map, H, W);
-    key.push_back('#');
-    key += std::to_string(s.reverseMap.player.x);
-    key.push_back(',');
-    key += std::to_string(s.reverseMap.player.y);
-    return key;
-}
-
-inline bool InBounds(Point p, int H, int W) noexcept {
-    return p.x >= 0 && p.x < W && p.y >= 0 && p.y < H;
+    tally.expanded = nodes.size();
+    tally.peakVisited = visited.Size();
+    tally.Publish();
+    return nullopt;
 }
 
-inline bool IsSolid(const Map& m, Point p) noexcept {
-    auto it = m.find(p);
-    if (it == m.end()) {
-        return false;  // пусто то есть нет в мапе значит точно не коробка и не стена
+void AI::BFS(Field& f, StepAnim& anim) {
+    optional<vector<Directions>> solution = Solve();
+    if (!solution) {
+        cout << "No solution found." << endl;
+        return;
+    }
+    // проигрываем решение на копии стартового поля, чтобы f оказалось в выигрышной позиции
+    f = initialField;
+    cout << "SOLUTION TO WIN" << endl;
+    cout << endl;
+    for (auto b : *solution) {
+        f.Move(b, anim);
+        if (b == Directions::LEFT) {
+            cout << "left" << endl;
+        }
+        if (b == Directions::RIGHT) {
+            cout << "right" << endl;
+        }
+        if (b == Directions::UP) {
+            cout << "up" << endl;
+        }
+        if (b == Directions::DOWN) {
+            cout << "down" << endl;
+        }
     }
-    return IsWallType(it->second) || it->second == BlockType::BOX;
 }
 
 std::vector<uint8_t>
@@ -436,74 +680,212 @@ ComputeReachableFlat(const Map& m, Point player, int H, int W) {
     return vis;
 }
 
-std::vector<StateForGenerator> GenerateNeighbors(const StateForGenerator& current, int H, int W) {
-    std::vector<StateForGenerator> neighbors;
+// Сетка занятости для узла: 0 — свободно, 1 — стена, 2 — ящик
+std::vector<uint8_t> Occupancy(const PushNode& n, const PushLevel& level) {
+    std::vector<uint8_t> occ(level.wall);
+    for (int i = 0; i < n.boxCount; i++) occ[n.boxes[i]] = 2;
+    return occ;
+}
+
+// Куда игрок может добраться БЕЗ толчков; top — самая верхняя левая из этих клеток.
+// Все позиции игрока внутри одной области для поиска по толчкам равноценны.
+std::vector<uint8_t> ReachableCells(const std::vector<uint8_t>& occ, Cell player, int H, int W, Cell& top) {
+    std::vector<uint8_t> vis(H * W, 0);
+    top = player;
+    if (occ[player])
+        return vis;
+    std::vector<Cell> stack{player};
+    vis[player] = 1;
+    auto visit = [&](int v) {
+        if (!occ[v] && !vis[v]) {
+            vis[v] = 1;
+            top = std::min(top, Cell(v));
+            stack.push_back(Cell(v));
+        }
+    };
+    while (!stack.empty()) {
+        int u = stack.back();
+        stack.pop_back();
+        int x = u % W, y = u / W;
+        if (x > 0)
+            visit(u - 1);
+        if (x < W - 1)
+            visit(u + 1);
+        if (y > 0)
+            visit(u - W);
+        if (y < H - 1)
+            visit(u + W);
+    }
+    return vis;
+}
+
+// Корень поиска из стартового состояния генератора
+PushNode MakePushNode(const StateForGenerator& s, const PushLevel& level) {
+    if (s.reverseMap.boxes.size() > kMaxBoxes)
+        throw std::runtime_error("Too many boxes for the push search");
+    PushNode n{};
+    n.boxes.fill(kNoCell);
+    n.boxCount = uint8_t(s.reverseMap.boxes.size());
+    for (int i = 0; i < n.boxCount; i++) {
+        Point b = s.reverseMap.boxes[i];
+        n.boxes[i] = Cell(b.y * level.W + b.x);
+        n.boxHash ^= ZobristKey(level.boxSlot[i], n.boxes[i]);
+    }
+    n.player = Cell(s.reverseMap.player.y * level.W + s.reverseMap.player.x);
+    n.parent = 0;
+
+    Cell top;
+    ReachableCells(Occupancy(n, level), n.player, level.H, level.W, top);
+    n.hash = n.boxHash ^ ZobristKey(kZobristPlayer, top);
+    return n;
+}
+
+// Как HaveWonMap: каждый ящик стоит на цели и ящиков столько же, сколько целей;
+// на цели с буквой — ящик той же буквы, как в Field::HaveWon
+bool IsSolvedPushNode(const PushNode& n, const PushLevel& level) {
+    if (n.boxCount != level.targets.size())
+        return false;
+    for (int i = 0; i < n.boxCount; i++) {
+        if (!level.target[n.boxes[i]])
+            return false;
+        const char letter = level.targetLetter[n.boxes[i]];
+        if (letter && letter != level.boxLetter[i])
+            return false;
+    }
+    return true;
+}
+
+// Толчки от корня (узел 0) до nodes[goal] по ссылкам на родителей
+std::vector<Directions> PushPath(const std::vector<PushNode>& nodes, uint32_t goal) {
+    std::vector<Directions> path;
+    for (uint32_t i = goal; i != 0; i = nodes[i].parent) {
+        path.push_back(nodes[i].push);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+// Результат поиска в прежнем виде: карта и ReverseMap с ящиками на местах, толчки — в movesHistory
+StateForGenerator SolvedState(const StateForGenerator& start, const PushNode& goal, std::vector<Directions> pushes, const PushLevel& level) {
+    StateForGenerator s = start;
+    for (Point b : s.reverseMap.boxes) s.map.Set(b, BlockType::EMPTY);
+    for (int i = 0; i < goal.boxCount; i++) {
+        Point b{goal.boxes[i] % level.W, goal.boxes[i] / level.W};
+        s.reverseMap.boxes[i] = b;
+        s.map.Set(b, BlockType::BOX);
+    }
+    s.reverseMap.player = {goal.player % level.W, goal.player / level.W};
+    s.movesHistory = std::move(pushes);
+    return s;
+}
+
+std::vector<PushNode> GenerateNeighbors(const PushNode& current, uint32_t index, const PushLevel& level, DeadlockTally& deadlocks) {
+    std::vector<PushNode> neighbors;
+    const int H = level.H;
+    const int W = level.W;
 
     auto idx = [W](Point p) { return p.y * W + p.x; };
     static const std::array<Point, 4> dirs{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
 
     // заливка — куда игрок может добраться БЕЗ толчков
-    auto vis = ComputeReachableFlat(current.map, current.reverseMap.player, H, W);
+    std::vector<uint8_t> occ = Occupancy(current, level);
+    Cell top;
+    auto vis = ReachableCells(occ, current.player, H, W, top);
+
+    // по той же заливке ищем коралы: если какой-то из них не решается — детей нет
+    if (IsCorralDeadlock(current, level, vis, deadlocks))
+        return neighbors;
 
     // для каждого ящика пробуем толкнуть в 4 стороны
-    for (Point b : current.reverseMap.boxes) {
+    for (int i = 0; i < current.boxCount; i++) {
+        Point b{current.boxes[i] % W, current.boxes[i] / W};
         for (Point d : dirs) {
             Point nn = {b.x + d.x, b.y + d.y};    // куда поедет ящик
             Point back = {b.x - d.x, b.y - d.y};  // откуда толкаем (игрок должен туда уметь встать)
 
-            if (!InBounds(nn, H, W) || IsSolid(current.map, nn))
+            if (!InBounds(nn, H, W) || occ[idx(nn)])
                 continue;  // впереди стена/ящик
             if (!InBounds(back, H, W) || !vis[idx(back)])
                 continue;  // игрок не может встать за ящик
-
-            // формируем новое состояние
-            StateForGenerator next = current;
-
-            // двигаем ящик в карте
-            next.map.erase(b);
-            next.map[nn] = BlockType::BOX;
-
-            // обновляем список ящиков
-            for (auto& bx : next.reverseMap.boxes) {
-                if (bx == b) {
-                    bx = nn;
-                    break;
-                }
+            if (level.dead[idx(nn)]) {
+                deadlocks.simple++;
+                continue;  // оттуда ящик уже не довезти ни до одной цели
             }
 
-            // игрок занимает место, где стоял ящик
-            next.reverseMap.player = b;
-
-            next.movesHistory.push_back(PointToDirection(d));
+            // двигаем ящик прямо в сетке, после проверок возвращаем на место
+            occ[idx(b)] = 0;
+            occ[idx(nn)] = 2;
+
+            // ящик встал намертво не на цели (у стены рядом с другим ящиком, квадрат 2x2 и т.п.)
+            if (!IsFreezeDeadlock(occ, level, nn, deadlocks)) {
+                PushNode next = current;
+                next.boxes[i] = Cell(idx(nn));
+                next.player = Cell(idx(b));  // игрок занимает место, где стоял ящик
+                next.push = PointToDirection(d);
+                next.parent = index;
+
+                // ключ: ящик b → nn за O(1), игрок — по своей новой области
+                next.boxHash ^= ZobristKey(level.boxSlot[i], idx(b)) ^ ZobristKey(level.boxSlot[i], idx(nn));
+                Cell nextTop;
+                ReachableCells(occ, next.player, H, W, nextTop);
+                next.hash = next.boxHash ^ ZobristKey(kZobristPlayer, nextTop);
+
+                neighbors.push_back(next);
+            }
 
-            neighbors.push_back(std::move(next));
+            occ[idx(nn)] = 0;
+            occ[idx(b)] = 2;
         }
     }
     return neighbors;
 }
 
-StateForGenerator BFSGenerated(const StateForGenerator& start, int H, int W) {
-    std::queue<StateForGenerator> q;
-    std::unordered_set<std::string> visited;
-
-    q.push(start);
-    visited.insert(SerializeState(start, H, W));
+StateForGenerator BFSGenerated(const StateForGenerator& start, int H, int W, std::stop_token stop, size_t memBytes) {
+    PushLevel level = BuildPushLevel(start, H, W);
+    for (const auto& b : start.reverseMap.boxes) {
+        if (!InBounds(b, H, W) || level.dead[b.y * W + b.x]) {
+            return {};  // ящик уже стоит в тупике
+        }
+    }
 
-    while (!q.empty()) {
-        StateForGenerator cur = std::move(q.front());
-        q.pop();
+    // узлы лежат в одном векторе, он же служит очередью FIFO: head — следующий к раскрытию
+    std::vector<PushNode> nodes{MakePushNode(start, level)};
+    TranspositionTable visited(SearchTableBytes(memBytes, sizeof(PushNode)));  // значение — номер узла в nodes
+    visited.Insert(nodes[0].hash, 0);
+    SearchTally tally;
+    auto publish = [&](size_t expanded) {
+        tally.expanded = expanded;
+        tally.peakVisited = visited.Size();
+        tally.Publish();
+    };
+
+    for (size_t head = 0; head < nodes.size(); head++) {
+        tally.Queue(nodes.size() - head);
+        if (stop.stop_requested()) {
+            publish(head);
+            return {};  // поиск отменён
+        }
 
-        if (HaveWonMap(cur))
-            return cur;
+        if (IsSolvedPushNode(nodes[head], level)) {
+            publish(head + 1);
+            return SolvedState(start, nodes[head], PushPath(nodes, uint32_t(head)), level);
+        }
 
-        for (auto& nxt : GenerateNeighbors(cur, H, W)) {
-            std::string key = SerializeState(nxt, H, W);
-            if (visited.insert(key).second) {
-                q.push(std::move(nxt));
+        for (const PushNode& nxt : GenerateNeighbors(nodes[head], uint32_t(head), level, tally.deadlocks)) {
+            tally.generated++;
+            TableInsert r = visited.Insert(nxt.hash, uint32_t(nodes.size()));
+            if (r == TableInsert::FOUND) {
+                tally.duplicates++;
+            } else if (r == TableInsert::INSERTED) {
+                nodes.push_back(nxt);
+            } else {
+                tally.gaveUp = true;
+                publish(head + 1);
+                return {};  // память поиска исчерпана
             }
         }
     }
-    std::cout << "No solution found\n";
+    publish(nodes.size());
     return {};  // нет решения
 }
 
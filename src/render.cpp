@@ -0,0 +1,143 @@
+#include "../inc/render.h"
+
+// Прямоугольник из двух треугольников (в SFML 3 нет примитива Quads)
+static void AppendQuad(sf::VertexArray& va, sf::FloatRect rect, sf::Color color, sf::FloatRect tex = {}) {
+    const sf::Vector2f p0 = rect.position;
+    const sf::Vector2f p1 = rect.position + rect.size;
+    const sf::Vector2f t0 = tex.position;
+    const sf::Vector2f t1 = tex.position + tex.size;
+    va.append({{p0.x, p0.y}, color, {t0.x, t0.y}});
+    va.append({{p1.x, p0.y}, color, {t1.x, t0.y}});
+    va.append({{p0.x, p1.y}, color, {t0.x, t1.y}});
+    va.append({{p0.x, p1.y}, color, {t0.x, t1.y}});
+    va.append({{p1.x, p0.y}, color, {t1.x, t0.y}});
+    va.append({{p1.x, p1.y}, color, {t1.x, t1.y}});
+}
+
+GlyphCache::GlyphCache(const sf::Font& f, unsigned size) : font(f), characterSize(size) {
+    // все глифы грузятся в текстуру сразу, поэтому прямоугольники дальше не меняются
+    for (char32_t c = 32; c < 128; c++) {
+        const sf::Glyph& glyph = font.getGlyph(c, characterSize, false);
+        quads[c].bounds = glyph.bounds;
+        quads[c].tex = sf::FloatRect(sf::Vector2f(glyph.textureRect.position), sf::Vector2f(glyph.textureRect.size));
+    }
+}
+
+// Буква по центру клетки — по её собственным границам, без вёрстки sf::Text
+void GlyphCache::AppendCentered(sf::VertexArray& va, char c, sf::FloatRect cell, sf::Color color) const {
+    if (c < 32 || c >= 127)
+        return;
+    const Quad& q = quads[c];
+    sf::Vector2f pos = cell.position + (cell.size - q.bounds.size) * 0.5f;
+    AppendQuad(va, {pos, q.bounds.size}, color, q.tex);
+}
+
+// Цвет клетки по символу поля; для ящиков и целей ещё и буква
+static sf::Color CellColor(char ch, char& letter) {
+    letter = 0;
+    switch (ch) {
+        case 'o':
+            return sf::Color(100, 100, 100);  // стена
+        case 'x':
+            return sf::Color::Red;  // игрок
+        default:
+            if (ch >= 'A' && ch <= 'Z') {  // ящики
+                letter = ch;
+                return sf::Color(0, 255, 0);
+            }
+            if (ch >= 'a' && ch <= 'z') {  // цели
+                letter = ch;
+                return sf::Color(0, 100, 255);
+            }
+            return sf::Color(40, 40, 40);  // пол
+    }
+}
+
+static bool IsPiece(char ch) {
+    return ch == 'x' || (ch >= 'A' && ch <= 'Z');
+}
+
+BoardRenderer::BoardRenderer(const sf::Font& font) : glyphs(font, unsigned(CELL_SIZE * 0.7f)) {}
+
+// Новый уровень: статический слой рисуется заново, фигуры собираются проходом по полю.
+// У f уже должен быть GameDescriptor — фон берётся из его emptyField.
+void BoardRenderer::Load(Field& f) {
+    const int W = f.GetWidth();
+    const int H = f.GetHeight();
+    if (!staticLayer.resize(sf::Vector2u(W * CELL_SIZE, H * CELL_SIZE))) {
+        std::cerr << "Не удалось создать текстуру поля" << std::endl;
+    }
+
+    Layer background;
+    pieces.clear();
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            char letter;
+            sf::Color color = CellColor(f.GetBackgroundAt({x, y}), letter);
+            Add(background, cellToPx(x, y), color, letter);
+            char ch = f.GetCell({x, y});
+            if (IsPiece(ch))
+                pieces.push_back({{x, y}, ch});
+        }
+    }
+    staticLayer.clear(sf::Color::Black);
+    Draw(staticLayer, background);
+    staticLayer.display();
+    f.TakeDirty();  // всё поле уже учтено
+}
+
+// Фигуры в изменённых клетках перечитываются из поля
+void BoardRenderer::Update(Field& f, const std::vector<Point>& dirty) {
+    for (Point p : dirty) {
+        std::erase_if(pieces, [p](const Piece& piece) { return piece.pos == p; });
+        char ch = f.GetCell(p);
+        if (IsPiece(ch))
+            pieces.push_back({p, ch});
+    }
+}
+
+void BoardRenderer::Clear() {
+    for (Layer* layer : {&dynamic, &moving}) {
+        layer->cells.clear();
+        layer->letters.clear();
+    }
+}
+
+// Ящики и игрок на своих клетках; анимируемых прячем — их рисует AddMoving
+void BoardRenderer::AddPieces(bool hidePlayer, std::optional<Point> hideBoxAt) {
+    for (const Piece& piece : pieces) {
+        if (piece.ch == 'x' && hidePlayer)
+            continue;
+        if (piece.ch != 'x' && hideBoxAt && *hideBoxAt == piece.pos)
+            continue;
+        char letter;
+        sf::Color color = CellColor(piece.ch, letter);
+        Add(dynamic, cellToPx(piece.pos.x, piece.pos.y), color, letter);
+    }
+}
+
+// Клетка размером CELL_SIZE - 2 в позиции pos (как у прежних RectangleShape) и, если задана, буква
+void BoardRenderer::Add(Layer& layer, sf::Vector2f pos, sf::Color color, char letter) {
+    sf::FloatRect rect(pos, {CELL_SIZE - 2.f, CELL_SIZE - 2.f});
+    AppendQuad(layer.cells, rect, color);
+    if (letter != 0)
+        glyphs.AppendCentered(layer.letters, letter, rect, sf::Color::Black);
+}
+
+void BoardRenderer::Draw(sf::RenderTarget& target, const Layer& layer) const {
+    if (layer.cells.getVertexCount() > 0) {
+        target.draw(layer.cells);
+        drawCalls++;
+    }
+    if (layer.letters.getVertexCount() > 0) {
+        target.draw(layer.letters, &glyphs.GetTexture());
+        drawCalls++;
+    }
+}
+
+void BoardRenderer::Draw(sf::RenderTarget& target) const {
+    target.draw(sf::Sprite(staticLayer.getTexture()));
+    drawCalls++;
+    Draw(target, dynamic);
+    Draw(target, moving);
+}
@@ -0,0 +1,207 @@
+// sokoban-solve — пакетное решение уровней из файла без окна.
+// Файл — сборник XSB (# $ . @ * +) или карты игры (o x A-N a-n), в том числе файл пула,
+// либо двоичный пакет sokoban-pack.
+// Уровни решаются параллельно (по уровню на поток) тем же поиском, что проверяет карты
+// генератора: A* в пределах памяти, дальше IDA* с таблицей того же размера. Результат —
+// по строке JSON на уровень в порядке готовности:
+//   {"level":3,"title":"...","status":"solved","search":"astar","pushes":12,"moves":40,"ms":5.1,"solution":"lurDD..."}
+// status: solved, unsolvable, timeout или error (тогда вместо решения — "error":"...").
+// Ящик с буквой формата игры поиск ставит только на цель той же буквы.
+// С --stats после прогона в FILE пишется статистика поисков (SearchCounters::ToJson).
+//
+// sokoban-solve FILE [--threads K] [--time-limit SEC] [--mem-limit MB] [--out FILE] [--stats FILE]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../inc/levels.h"
+#include "../inc/pack.h"
+#include "../inc/prog.h"
+
+static void Usage() {
+    std::cerr << "usage: sokoban-solve FILE [--threads K] [--time-limit SEC] [--mem-limit MB] [--out FILE] [--stats FILE]\n";
+}
+
+// Цена узла A*: узел, три записи таблицы bestG (её ёмкость — до 8/3 бюджета узлов) и запись очереди;
+// таблица IDA* — ровно по записи TranspositionTable
+constexpr size_t kAStarBytesPerNode = sizeof(PushNode) + 3 * TranspositionTable::kEntryBytes + 24;
+constexpr size_t kIdaBytesPerEntry = TranspositionTable::kEntryBytes;
+
+struct SolveResult {
+    std::string status;
+    std::string search;
+    std::string error;
+    std::vector<Directions> pushes;
+    std::string lurd;
+    double ms = 0;
+};
+
+// Экранирование для строк JSON (названия уровней берутся из файла как есть)
+static std::string JsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20)
+            continue;
+        out += c;
+    }
+    return out + '"';
+}
+
+// Решает один уровень; stop срабатывает по таймеру
+static SolveResult SolveLevel(const ParsedLevel& level, size_t memBytes, std::stop_token stop) {
+    SolveResult r;
+    auto t0 = std::chrono::steady_clock::now();
+    try {
+        StateForGenerator solved;
+        r.search = "astar";
+        if (auto astar = AStarGenerated(level.start, level.height, level.width, memBytes / kAStarBytesPerNode, stop)) {
+            solved = std::move(*astar);
+        } else {
+            r.search = "idastar";
+            solved = IDAStarGenerated(level.start, level.height, level.width, memBytes / kIdaBytesPerEntry, stop);
+        }
+        // решение, найденное как раз к срабатыванию таймера, всё равно засчитывается
+        if (!HaveWonMap(solved)) {
+            r.status = stop.stop_requested() ? "timeout" : "unsolvable";
+        } else if (auto lurd = PushesToLurd(level, solved.movesHistory)) {
+            r.status = "solved";
+            r.pushes = std::move(solved.movesHistory);
+            r.lurd = std::move(*lurd);
+        } else {
+            r.status = "error";
+            r.error = "push solution does not replay";
+        }
+    } catch (const std::exception& e) {
+        r.status = "error";
+        r.error = e.what();
+    }
+    r.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return r;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        Usage();
+        return 2;
+    }
+    std::string inName = argv[1];
+    std::string outName;
+    std::string statsName;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    double timeLimit = 10;
+    size_t memLimitMb = 512;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            Usage();
+            return 2;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--threads")
+                threads = std::max(1, std::stoi(value));
+            else if (arg == "--time-limit")
+                timeLimit = std::stod(value);
+            else if (arg == "--mem-limit")
+                memLimitMb = std::stoul(value);
+            else if (arg == "--out")
+                outName = value;
+            else if (arg == "--stats")
+                statsName = value;
+            else {
+                Usage();
+                return 2;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "bad value for " << arg << ": " << value << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<ParsedLevel> levels;
+    if (IsLevelPack(inName)) {
+        try {
+            LevelPack pack(inName);
+            for (size_t i = 0; i < pack.Size(); i++) levels.push_back(pack[i].ToParsed());
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    } else {
+        std::ifstream in(inName);
+        if (!in) {
+            std::cerr << "cannot open " << inName << std::endl;
+            return 1;
+        }
+        levels = ReadLevelCollection(in);
+    }
+    std::cerr << "Loaded " << levels.size() << " levels from " << inName << std::endl;
+
+    std::ofstream file;
+    if (!outName.empty()) {
+        file.open(outName);
+        if (!file) {
+            std::cerr << "cannot open " << outName << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = outName.empty() ? std::cout : file;
+    GetSearchCounters().enabled = !statsName.empty();
+
+    const size_t memBytes = memLimitMb << 20;
+    const auto limit = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeLimit));
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> solvedCount{0};
+    std::mutex outMutex;
+    auto worker = [&] {
+        for (size_t i = next++; i < levels.size(); i = next++) {
+            std::stop_source deadline;
+            // таймер уровня: по истечении limit останавливает поиск, после поиска сразу выходит
+            std::jthread timer([&deadline, limit](std::stop_token done) {
+                std::mutex m;
+                std::condition_variable_any cv;
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait_for(lock, done, limit, [] { return false; });
+                if (!done.stop_requested())
+                    deadline.request_stop();
+            });
+            SolveResult r = SolveLevel(levels[i], memBytes, deadline.get_token());
+            timer.request_stop();
+
+            if (r.status == "solved")
+                solvedCount++;
+            std::lock_guard<std::mutex> lock(outMutex);
+            out << "{\"level\":" << i << ",\"title\":" << JsonString(levels[i].title) << ",\"status\":\"" << r.status
+                << "\",\"search\":\"" << r.search << "\"";
+            if (r.status == "solved")
+                out << ",\"pushes\":" << r.pushes.size() << ",\"moves\":" << r.lurd.size();
+            out << ",\"ms\":" << r.ms;
+            if (r.status == "solved")
+                out << ",\"solution\":\"" << r.lurd << "\"";
+            if (!r.error.empty())
+                out << ",\"error\":" << JsonString(r.error);
+            out << "}\n";
+            out.flush();
+        }
+    };
+
+    {
+        std::vector<std::jthread> pool;
+        for (unsigned t = 0; t < threads; t++) pool.emplace_back(worker);
+    }
+    std::cerr << "Solved " << solvedCount << " of " << levels.size() << std::endl;
+    if (!statsName.empty() && !(std::ofstream(statsName) << GetSearchCounters().ToJson() << '\n')) {
+        std::cerr << "cannot write " << statsName << std::endl;
+        return 1;
+    }
+    return solvedCount == levels.size() ? 0 : 1;
+}
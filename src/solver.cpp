@@ -0,0 +1,880 @@
+// Поиск по толчкам с оценкой снизу: A* и IDA* рядом с BFSGenerated, BFS по слоям на нескольких потоках
+// и обратный поиск тягами для генератора
+#include <algorithm>
+#include <barrier>
+#include <bit>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "../inc/prog.h"
+
+static const std::array<Point, 4> kPushDirs{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+
+// Таблицы уровня: стены из стартовой карты (без ящиков) и для каждой цели — сколько
+// толчков нужно ящику из любой клетки, чтобы дойти до неё, если других ящиков нет.
+// Считается обратной волной от цели: ящик из q толкается в p = q + d, если
+// q - d (место игрока) и p — не стены.
+PushLevel BuildPushLevel(const StateForGenerator& start, int H, int W) {
+    PushLevel level;
+    level.H = H;
+    level.W = W;
+    level.wall.assign(H * W, 0);
+    level.targets = start.reverseMap.targets;
+    level.target.assign(H * W, 0);
+    level.targetLetter.assign(H * W, 0);
+    const ReverseMap& rev = start.reverseMap;
+    for (size_t i = 0; i < level.targets.size(); i++) {
+        Point t = level.targets[i];
+        if (!InBounds(t, H, W))
+            continue;
+        level.target[t.y * W + t.x] = 1;
+        if (i < rev.targetLetters.size() && rev.targetLetters[i]) {
+            level.targetLetter[t.y * W + t.x] = rev.targetLetters[i];
+            level.lettered = true;
+        }
+    }
+    // ящики одной буквы взаимозаменяемы, ящики без буквы — тоже, поэтому слот Zobrist — буква
+    level.boxLetter.assign(rev.boxes.size(), 0);
+    level.boxSlot.assign(rev.boxes.size(), kZobristBox);
+    for (size_t i = 0; i < rev.boxes.size() && i < rev.boxLetters.size(); i++) {
+        if (rev.boxLetters[i]) {
+            level.boxLetter[i] = rev.boxLetters[i];
+            level.boxSlot[i] = uint32_t(rev.boxLetters[i] - 'a');
+        }
+    }
+
+    Point pt;
+    for (pt.y = 0; pt.y < H; pt.y++) {
+        for (pt.x = 0; pt.x < W; pt.x++) {
+            if (IsWallType(start.map.At(pt)))
+                level.wall[pt.y * W + pt.x] = 1;
+        }
+    }
+    auto isFloor = [&](Point p) { return InBounds(p, H, W) && !level.wall[p.y * W + p.x]; };
+
+    level.pushDist.assign(level.targets.size(), std::vector<uint16_t>(H * W, kInfDist));
+    for (size_t t = 0; t < level.targets.size(); t++) {
+        std::vector<uint16_t>& dist = level.pushDist[t];
+        Point target = level.targets[t];
+        if (!isFloor(target))
+            continue;
+        std::queue<Point> q;
+        dist[target.y * W + target.x] = 0;
+        q.push(target);
+        while (!q.empty()) {
+            Point p = q.front();
+            q.pop();
+            for (Point d : kPushDirs) {
+                Point from = p - d;       // где стоял ящик
+                Point player = from - d;  // откуда его толкали
+                if (!isFloor(from) || !isFloor(player))
+                    continue;
+                uint16_t& df = dist[from.y * W + from.x];
+                if (df != kInfDist)
+                    continue;
+                df = dist[p.y * W + p.x] + 1;
+                q.push(from);
+            }
+        }
+    }
+
+    // простые тупики: клетка, которую не затронула ни одна обратная волна
+    level.dead.assign(H * W, 1);
+    for (const auto& dist : level.pushDist) {
+        for (int c = 0; c < H * W; c++) {
+            if (dist[c] != kInfDist)
+                level.dead[c] = 0;
+        }
+    }
+    return level;
+}
+
+// Минимальная стоимость назначения ящиков на цели (венгерский алгоритм, O(n^3)).
+// Стоимость пары — число толчков из pushDist; на цель с буквой годится только ящик той же буквы.
+// Если хоть один ящик не может дойти ни до одной подходящей цели, возвращаем kInfDist:
+// такое состояние — тупик.
+int MatchingLowerBound(const PushLevel& level, const PushNode& node) {
+    const int n = node.boxCount;
+    if (n != int(level.targets.size()))
+        return kInfDist;
+    if (n == 0)
+        return 0;
+
+    const int kBig = kInfDist;  // «невозможная» пара дороже любого реального назначения
+    std::vector<std::vector<int>> cost(n, std::vector<int>(n));
+    for (int i = 0; i < n; i++) {
+        int cell = node.boxes[i];
+        bool reachable = false;
+        for (int j = 0; j < n; j++) {
+            const Point t = level.targets[j];
+            const char letter = level.targetLetter[t.y * level.W + t.x];
+            const bool fits = !letter || letter == level.boxLetter[i];
+            const bool pair = fits && level.pushDist[j][cell] != kInfDist;
+            cost[i][j] = pair ? level.pushDist[j][cell] : kBig * n;
+            reachable |= pair;
+        }
+        if (!reachable)
+            return kInfDist;
+    }
+
+    // классическая форма с потенциалами u, v и массивом паросочетания p (индексы с 1)
+    const int INF = std::numeric_limits<int>::max() / 2;
+    std::vector<int> u(n + 1), v(n + 1), p(n + 1), way(n + 1);
+    for (int i = 1; i <= n; i++) {
+        p[0] = i;
+        int j0 = 0;
+        std::vector<int> minv(n + 1, INF);
+        std::vector<char> used(n + 1, false);
+        do {
+            used[j0] = true;
+            int i0 = p[j0], delta = INF, j1 = 0;
+            for (int j = 1; j <= n; j++) {
+                if (used[j])
+                    continue;
+                int cur = cost[i0 - 1][j - 1] - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= n; j++) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+
+    int total = 0;
+    for (int j = 1; j <= n; j++) {
+        int c = cost[p[j] - 1][j - 1];
+        if (c >= kBig)
+            return kInfDist;  // без невозможной пары не обойтись
+        total += c;
+    }
+    return total;
+}
+
+// A*: очередь по f = g + h, при равных f раньше раскрываем более глубокие узлы.
+// Оценка согласована (толчок меняет расстояние одного ящика не больше чем на 1),
+// поэтому первое снятое из очереди решение оптимально по числу толчков.
+// Если узлов становится больше maxNodes — сдаёмся и возвращаем nullopt.
+std::optional<StateForGenerator> AStarGenerated(const StateForGenerator& start, int H, int W, size_t maxNodes, std::stop_token stop) {
+    PushLevel level = BuildPushLevel(start, H, W);
+
+    struct Entry {
+        int f;
+        int g;
+        size_t index;
+        bool operator<(const Entry& o) const {
+            return f != o.f ? f > o.f : g < o.g;
+        }
+    };
+
+    // пул узлов: в очереди только индексы, путь восстанавливается по parent.
+    // Таблица bestG — наименьшая степень двойки, которая при заполнении до 3/4 вмещает maxNodes
+    // ключей, но вместе с узлами и очередью не больше kSearchMemoryBytes; если она заполнилась
+    // раньше бюджета узлов — сдаёмся так же.
+    std::vector<PushNode> nodes{MakePushNode(start, level)};
+    const size_t memoryTable = SearchTableBytes(kSearchMemoryBytes, sizeof(PushNode) + sizeof(Entry));
+    const size_t memoryEntries = memoryTable / TranspositionTable::kEntryBytes;
+    const size_t tableBytes =
+        maxNodes < memoryEntries
+            ? std::min(std::bit_ceil((maxNodes * 4 + 2) / 3) * TranspositionTable::kEntryBytes, memoryTable)
+            : memoryTable;
+    TranspositionTable bestG(tableBytes);
+    std::priority_queue<Entry> open;
+
+    int h0 = MatchingLowerBound(level, nodes[0]);
+    if (h0 >= kInfDist)
+        return StateForGenerator{};  // тупик уже в начале — решения нет
+    bestG.Insert(nodes[0].hash, 0);
+    open.push({h0, 0, 0});
+
+    SearchTally tally;
+    auto publish = [&] {
+        tally.peakVisited = bestG.Size();
+        tally.Publish();
+    };
+    while (!open.empty()) {
+        if (stop.stop_requested()) {
+            publish();
+            return StateForGenerator{};  // поиск отменён
+        }
+        tally.Queue(open.size());
+        Entry e = open.top();
+        open.pop();
+        if (int(*bestG.Find(nodes[e.index].hash)) < e.g)
+            continue;  // устаревшая запись, узел уже найден короче
+        tally.expanded++;
+        if (IsSolvedPushNode(nodes[e.index], level)) {
+            publish();
+            return SolvedState(start, nodes[e.index], PushPath(nodes, uint32_t(e.index)), level);
+        }
+
+        for (const PushNode& nxt : GenerateNeighbors(nodes[e.index], uint32_t(e.index), level, tally.deadlocks)) {
+            tally.generated++;
+            int g = e.g + 1;
+            uint32_t* known = bestG.Find(nxt.hash);
+            if (known && int(*known) <= g) {
+                tally.duplicates++;
+                continue;
+            }
+            int h = MatchingLowerBound(level, nxt);
+            if (h >= kInfDist)
+                continue;
+            if (nodes.size() >= maxNodes || (!known && bestG.Insert(nxt.hash, g) == TableInsert::FULL)) {
+                tally.gaveUp = true;
+                publish();
+                return std::nullopt;
+            }
+            if (known)
+                *known = g;
+            nodes.push_back(nxt);
+            open.push({g + h, g, nodes.size() - 1});
+        }
+    }
+    publish();
+    return StateForGenerator{};  // нет решения
+}
+
+// Один проход IDA* с порогом bound. Рекурсия — обычная функция-член, без std::function:
+// на каждом узле лишний косвенный вызов заметен.
+struct IdaPass {
+    const PushLevel& level;
+    TranspositionTable& seen;
+    std::vector<Directions>& path;
+    std::optional<PushNode>& found;
+    SearchTally& tally;
+    std::stop_token stop;
+    size_t maxExpanded;
+    int bound;
+
+    // h — оценка cur, её уже посчитал родитель; возвращает минимальное f, превысившее порог
+    // (kInfDist — дальше идти некуда)
+    int Dfs(const PushNode& cur, int g, int h) {
+        if (stop.stop_requested() || tally.gaveUp)
+            return kInfDist;
+        if (g + h > bound)
+            return g + h;
+        if (IsSolvedPushNode(cur, level)) {
+            found = cur;
+            return g;
+        }
+        uint32_t* known;
+        if (seen.Insert(cur.hash, uint32_t(g), &known) == TableInsert::FOUND) {
+            if (int(*known) <= g) {
+                tally.duplicates++;
+                return kInfDist;  // сюда уже приходили не дороже на этой итерации
+            }
+            *known = uint32_t(g);
+        }
+
+        if (++tally.expanded > maxExpanded) {
+            tally.gaveUp = true;
+            return kInfDist;
+        }
+        tally.Queue(path.size());
+        int next = kInfDist;
+        for (const PushNode& nxt : GenerateNeighbors(cur, 0, level, tally.deadlocks)) {
+            tally.generated++;
+            int hn = MatchingLowerBound(level, nxt);
+            if (hn >= kInfDist)
+                continue;
+            path.push_back(nxt.push);
+            int t = Dfs(nxt, g + 1, hn);
+            if (found)
+                return t;
+            path.pop_back();
+            next = std::min(next, t);
+        }
+        return next;
+    }
+};
+
+// IDA*: поиск в глубину с порогом по f, порог растёт до ближайшего превышения.
+// Память — только путь (толчки в path) и таблица «лучший g на этой итерации» на maxTable
+// записей. Таблица — кэш: заполнившись, она затирает старые записи (TableFullPolicy::REPLACE),
+// и вытесненные состояния раскрываются заново, поэтому на большом пространстве нужен maxExpanded.
+StateForGenerator IDAStarGenerated(const StateForGenerator& start, int H, int W, size_t maxTable, std::stop_token stop,
+                                   size_t maxExpanded) {
+    PushLevel level = BuildPushLevel(start, H, W);
+    PushNode root = MakePushNode(start, level);
+
+    const int h0 = MatchingLowerBound(level, root);
+    if (h0 >= kInfDist)
+        return StateForGenerator{};
+
+    TranspositionTable seen(maxTable * TranspositionTable::kEntryBytes, TableFullPolicy::REPLACE);
+    std::vector<Directions> path;
+    std::optional<PushNode> found;
+    SearchTally tally;
+    IdaPass pass{level, seen, path, found, tally, stop, maxExpanded, h0};
+
+    while (true) {
+        seen.Clear();
+        int t = pass.Dfs(root, 0, h0);
+        tally.peakVisited = std::max<uint64_t>(tally.peakVisited, seen.Size());
+        if (found) {
+            tally.Publish();
+            return SolvedState(start, *found, path, level);
+        }
+        if (t >= kInfDist || stop.stop_requested() || tally.gaveUp) {
+            tally.Publish();
+            return StateForGenerator{};  // все достижимые состояния исчерпаны или бюджет кончился
+        }
+        pass.bound = t;
+    }
+}
+
+// Потоки параллельного BFS: создаются один раз на поиск и ждут на барьере, а не заводятся
+// заново на каждый проход слоя. For(n, f) режет [0, n) на threads непрерывных кусков; первый
+// кусок считает вызывающий поток, For возвращается, когда готовы все куски.
+class LayerWorkers {
+   private:
+    const unsigned threads;
+    size_t count = 0;
+    const void* task = nullptr;
+    void (*run)(const void*, size_t, size_t) = nullptr;
+    bool quit = false;
+    std::barrier<> start;
+    std::barrier<> done;
+    std::vector<std::jthread> workers;
+
+    void Chunk(unsigned t) const {
+        const size_t chunk = (count + threads - 1) / threads;
+        const size_t begin = std::min(count, t * chunk);
+        const size_t end = std::min(count, begin + chunk);
+        if (begin < end)
+            run(task, begin, end);
+    }
+
+   public:
+    explicit LayerWorkers(unsigned n) : threads(std::max(1u, n)), start(threads), done(threads) {
+        for (unsigned t = 1; t < threads; t++) {
+            workers.emplace_back([this, t] {
+                while (true) {
+                    start.arrive_and_wait();
+                    if (quit)
+                        return;
+                    Chunk(t);
+                    done.arrive_and_wait();
+                }
+            });
+        }
+    }
+
+    ~LayerWorkers() {
+        quit = true;
+        start.arrive_and_wait();
+    }
+
+    // Мало работы — весь отрезок в вызывающем потоке, без барьеров
+    template <typename F>
+    void For(size_t n, const F& f) {
+        if (threads <= 1 || n < 2 * size_t(threads)) {
+            f(size_t(0), n);
+            return;
+        }
+        count = n;
+        task = &f;
+        run = [](const void* fn, size_t begin, size_t end) { (*static_cast<const F*>(fn))(begin, end); };
+        start.arrive_and_wait();
+        Chunk(0);
+        done.arrive_and_wait();
+    }
+};
+
+// Visited для параллельного BFS: шарды TranspositionTable с отдельными мьютексами, память всех
+// шардов вместе — memBytes. Для каждого ключа хранится наименьший порядковый номер ребёнка,
+// который его породил. Шард, заполнившийся раньше остальных, останавливает поиск так же, как
+// заполненная таблица BFSGenerated.
+class ShardedVisited {
+   private:
+    struct Shard {
+        std::mutex mutex;
+        TranspositionTable table{0};
+    };
+    std::vector<Shard> shards;
+
+    Shard& For(uint64_t key) { return shards[(key >> 32) % shards.size()]; }
+
+   public:
+    ShardedVisited(size_t count, size_t memBytes) : shards(count) {
+        for (Shard& s : shards) s.table = TranspositionTable(memBytes / count);
+    }
+
+    // Оставляет min(старый номер, ordinal); false — в шарде нет места под новый ключ
+    bool Offer(uint64_t key, uint32_t ordinal) {
+        Shard& s = For(key);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        uint32_t* known;
+        TableInsert r = s.table.Insert(key, ordinal, &known);
+        if (r == TableInsert::FOUND && ordinal < *known)
+            *known = ordinal;
+        return r != TableInsert::FULL;
+    }
+
+    // Contains и Owns — только между проходами Offer: таблицы никто не меняет, поэтому без мьютекса
+    bool Contains(uint64_t key) { return For(key).table.Find(key) != nullptr; }
+    bool Owns(uint64_t key, uint32_t ordinal) { return *For(key).table.Find(key) == ordinal; }
+
+    size_t Size() const {
+        size_t size = 0;
+        for (const Shard& s : shards) size += s.table.Size();
+        return size;
+    }
+};
+
+constexpr size_t kParallelSlice = 1024;  // родителей на поток за один проход раскрытия
+
+// BFS по слоям: слой раскрывается кусками на нескольких потоках, дети получают сквозной
+// номер — сколько детей было порождено до них в порядке последовательного BFS. Номера детей
+// больше номеров всех ранее принятых узлов, поэтому ребёнок остаётся, только если его номер
+// наименьший для его ключа, и следующий слой, найденное решение и movesHistory в точности
+// совпадают с BFSGenerated. Номер 32-битный: кончились номера или память visited — поиск сдаётся.
+// Слой раскрывается срезами по kParallelSlice родителей на поток: детей, которых ещё не
+// отсеял visited, держим только для одного среза, а не для всего слоя.
+// Все принятые узлы лежат в общем пуле nodes, слой — это отрезок [layerBegin, layerEnd).
+StateForGenerator ParallelBFSGenerated(const StateForGenerator& start, int H, int W, unsigned threads, std::stop_token stop,
+                                       size_t memBytes) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    PushLevel level = BuildPushLevel(start, H, W);
+    for (const auto& b : start.reverseMap.boxes) {
+        if (!InBounds(b, H, W) || level.dead[b.y * W + b.x])
+            return {};  // ящик уже стоит в тупике
+    }
+
+    ShardedVisited visited(16 * size_t(threads), SearchTableBytes(memBytes, sizeof(PushNode)));
+    LayerWorkers workers(threads);
+    std::vector<PushNode> nodes{MakePushNode(start, level)};
+    visited.Offer(nodes[0].hash, 0);
+    size_t layerBegin = 0;
+    uint64_t ordinal = 1;  // номер следующего ребёнка
+
+    // слой раскрывается целиком, поэтому раскрытые — все узлы прошлых слоёв, очередь — слой
+    SearchTally tally;
+    auto publish = [&] {
+        tally.expanded = layerBegin;
+        tally.peakVisited = visited.Size();
+        tally.Publish();
+    };
+    while (layerBegin < nodes.size()) {
+        if (stop.stop_requested()) {
+            publish();
+            return {};
+        }
+        const size_t layerEnd = nodes.size();
+        const size_t layerSize = layerEnd - layerBegin;
+        tally.Queue(layerSize);
+
+        // 1) первое по порядку решение в слое
+        const PushNode* layer = nodes.data() + layerBegin;
+        std::atomic<size_t> won{layerSize};
+        workers.For(layerSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end && i < won; i++) {
+                if (IsSolvedPushNode(layer[i], level)) {
+                    size_t cur = won;
+                    while (i < cur && !won.compare_exchange_weak(cur, i)) {
+                    }
+                    return;
+                }
+            }
+        });
+        if (won < layerSize) {
+            publish();
+            return SolvedState(start, layer[won], PushPath(nodes, uint32_t(layerBegin + won)), level);
+        }
+
+        const size_t sliceSize = kParallelSlice * threads;
+        for (size_t sliceBegin = layerBegin; sliceBegin < layerEnd; sliceBegin += sliceSize) {
+            // дети прошлого среза дописаны в nodes, и вектор мог переехать
+            const PushNode* slice = nodes.data() + sliceBegin;
+            const size_t count = std::min(sliceSize, layerEnd - sliceBegin);
+
+            // 2) раскрытие: дети каждого родителя в том же порядке, что и у последовательного BFS.
+            // Кусок пишет детей подряд в свой буфер parts[begin], offset[i + 1] — сколько детей у i.
+            // Ключи, уже принятые в visited, здесь не меняются — таких детей отбрасываем сразу.
+            // Счётчики у каждого куска свои и сливаются в tally один раз за кусок.
+            std::vector<std::vector<PushNode>> parts(count);
+            std::vector<uint64_t> offset(count + 1, 0);
+            std::mutex merge;
+            workers.For(count, [&](size_t begin, size_t end) {
+                DeadlockTally deadlocks;
+                uint64_t generated = 0;
+                uint64_t seen = 0;
+                std::vector<PushNode>& part = parts[begin];
+                for (size_t i = begin; i < end && !stop.stop_requested(); i++) {
+                    for (const PushNode& c : GenerateNeighbors(slice[i], uint32_t(sliceBegin + i), level, deadlocks)) {
+                        generated++;
+                        if (visited.Contains(c.hash)) {
+                            seen++;
+                            continue;
+                        }
+                        part.push_back(c);
+                        offset[i + 1]++;
+                    }
+                }
+                std::lock_guard<std::mutex> lock(merge);
+                tally.deadlocks += deadlocks;
+                tally.generated += generated;
+                tally.duplicates += seen;
+            });
+
+            for (size_t i = 0; i < count; i++) offset[i + 1] += offset[i];
+            const uint64_t base = ordinal;
+            ordinal += offset.back();
+            if (ordinal > std::numeric_limits<uint32_t>::max()) {
+                tally.gaveUp = true;
+                publish();
+                return {};  // номера детей больше не помещаются в запись visited
+            }
+
+            // 3) каждый ключ запоминает наименьший номер; у принятых раньше он уже меньше любого нового.
+            // For режет тот же count на те же куски, поэтому дети куска — снова parts[begin].
+            std::atomic<bool> full{false};
+            workers.For(count, [&](size_t begin, size_t) {
+                const std::vector<PushNode>& part = parts[begin];
+                for (size_t k = 0; k < part.size() && !full; k++) {
+                    if (!visited.Offer(part[k].hash, uint32_t(base + offset[begin] + k)))
+                        full = true;
+                }
+            });
+            if (full) {
+                tally.gaveUp = true;
+                publish();
+                return {};  // память поиска исчерпана
+            }
+
+            // 4) дальше идут только «владельцы» своих ключей
+            std::vector<uint8_t> keep(offset.back(), 0);
+            workers.For(count, [&](size_t begin, size_t) {
+                const std::vector<PushNode>& part = parts[begin];
+                for (size_t k = 0; k < part.size(); k++) {
+                    const uint64_t n = offset[begin] + k;
+                    keep[n] = visited.Owns(part[k].hash, uint32_t(base + n));
+                }
+            });
+
+            // куски идут по возрастанию begin, так что подряд — это порядок последовательного BFS
+            const size_t before = nodes.size();
+            size_t n = 0;
+            for (const std::vector<PushNode>& part : parts) {
+                for (const PushNode& c : part) {
+                    if (keep[n++])
+                        nodes.push_back(c);
+                }
+            }
+            tally.duplicates += offset.back() - (nodes.size() - before);
+        }
+        layerBegin = layerEnd;
+    }
+    publish();
+    return {};  // нет решения
+}
+
+// Режим AUTO: A* пока хватает бюджета узлов, иначе тот же старт решается IDA*
+StateForGenerator SolveGenerated(const StateForGenerator& start, int H, int W, SolverMode mode, std::stop_token stop) {
+    switch (mode) {
+        case SolverMode::BFS:
+            return BFSGenerated(start, H, W, stop);
+        case SolverMode::ASTAR:
+            // без бюджета узлов A* сдаётся только по памяти таблицы — как BFS, уровень не принимаем
+            return AStarGenerated(start, H, W, std::numeric_limits<size_t>::max(), stop).value_or(StateForGenerator{});
+        case SolverMode::IDASTAR:
+            return IDAStarGenerated(start, H, W, kIdaTableBytes / TranspositionTable::kEntryBytes, stop);
+        case SolverMode::PARALLEL_BFS:
+            return ParallelBFSGenerated(start, H, W, 0, stop);
+        case SolverMode::BIDIRECTIONAL:
+            return BidirectionalBFSGenerated(start, H, W, stop);
+        case SolverMode::AUTO:
+        case SolverMode::REVERSE:  // готовую карту обратный режим решает как AUTO
+            break;
+    }
+    if (auto solved = AStarGenerated(start, H, W, kAStarNodeBudget, stop))
+        return *solved;
+    if (GetSearchCounters().enabled.load(std::memory_order_relaxed))
+        GetSearchCounters().astarFallbacks++;
+    return IDAStarGenerated(start, H, W, kIdaTableBytes / TranspositionTable::kEntryBytes, stop, kIdaNodeBudget);
+}
+
+// Корни обратного поиска: ящики root, игрок — по одному в каждой области свободных клеток.
+// Корень ссылается сам на себя (parent — его номер среди корней, начиная с base).
+static std::vector<PushNode> PullSources(const PushNode& root, const PushLevel& level, uint32_t base = 0) {
+    const int H = level.H;
+    const int W = level.W;
+    std::vector<PushNode> sources;
+    std::vector<uint8_t> occ = Occupancy(root, level);
+    std::vector<uint8_t> covered(H * W, 0);
+    for (int c = 0; c < H * W; c++) {
+        if (occ[c] || covered[c])
+            continue;
+        Cell top;
+        std::vector<uint8_t> reach = ReachableCells(occ, Cell(c), H, W, top);
+        for (int i = 0; i < H * W; i++) covered[i] |= reach[i];
+        PushNode source = root;
+        source.player = Cell(c);
+        source.hash = source.boxHash ^ ZobristKey(kZobristPlayer, top);
+        source.parent = base + uint32_t(sources.size());
+        sources.push_back(source);
+    }
+    return sources;
+}
+
+// Тяги из cur: grid — его сетка занятости (возвращается без изменений), reach — область игрока.
+// Тяга — игрок стоит в q рядом с ящиком в q + d, отходит в q - d и тянет ящик в q;
+// в push ребёнка пишется толчок, который вернёт ящик обратно.
+static std::vector<PushNode> GeneratePulls(const PushNode& cur, uint32_t index, const PushLevel& level, std::vector<uint8_t>& grid,
+                                           const std::vector<uint8_t>& reach) {
+    const int H = level.H;
+    const int W = level.W;
+    std::vector<PushNode> pulls;
+    for (int i = 0; i < cur.boxCount; i++) {
+        Point b{cur.boxes[i] % W, cur.boxes[i] / W};
+        for (Point d : kPushDirs) {
+            Point q = b - d;     // где стоит игрок
+            Point to = q - d;    // куда он отходит
+            if (!InBounds(to, H, W) || !InBounds(q, H, W) || !reach[q.y * W + q.x] || grid[to.y * W + to.x])
+                continue;
+
+            PushNode next = cur;
+            int from = b.y * W + b.x;
+            int cell = q.y * W + q.x;
+            next.boxes[i] = Cell(cell);
+            next.player = Cell(to.y * W + to.x);
+            next.push = PointToDirection(d);
+            next.parent = index;
+            next.boxHash ^= ZobristKey(level.boxSlot[i], from) ^ ZobristKey(level.boxSlot[i], cell);
+
+            grid[from] = 0;
+            grid[cell] = 2;
+            Cell nextTop;
+            ReachableCells(grid, next.player, H, W, nextTop);
+            grid[cell] = 0;
+            grid[from] = 2;
+            next.hash = next.boxHash ^ ZobristKey(kZobristPlayer, nextTop);
+            pulls.push_back(next);
+        }
+    }
+    return pulls;
+}
+
+// Обратный поиск для генератора: BFS по тягам. Тяга — игрок стоит в q рядом с ящиком в q + d,
+// отходит в q - d и тянет ящик в q; обратная к ней операция — толчок из q - d в сторону d.
+// Поиск стартует сразу из всех решённых состояний (ящики на целях, игрок в любой своей области),
+// поэтому глубина узла при открытии — ровно минимальное число толчков до решения.
+// Из узлов с максимальной глубиной берём первый, который можно записать текстом карты:
+// ни ящик, ни игрок не стоят на цели. Поиск ограничен maxNodes узлами.
+StateForGenerator FarthestPullState(const StateForGenerator& goal, int H, int W, size_t maxNodes, std::stop_token stop) {
+    PushLevel level = BuildPushLevel(goal, H, W);
+    std::vector<PushNode> nodes;
+    std::vector<uint16_t> depth;
+    TranspositionTable visited;  // заполнилась — новые состояния не открываются, как при бюджете узлов
+
+    // источники: по одному на каждую область свободных клеток вокруг расставленных ящиков
+    for (const PushNode& source : PullSources(MakePushNode(goal, level), level)) {
+        visited.Insert(source.hash, uint32_t(nodes.size()));
+        nodes.push_back(source);
+        depth.push_back(0);
+    }
+
+    // клетка области игрока, куда его можно поставить в тексте карты (не цель), или kNoCell
+    auto startCell = [&](const PushNode& n, const std::vector<uint8_t>& reach) -> Cell {
+        for (int i = 0; i < n.boxCount; i++) {
+            if (level.target[n.boxes[i]])
+                return kNoCell;
+        }
+        if (!level.target[n.player])
+            return n.player;
+        for (int c = 0; c < H * W; c++) {
+            if (reach[c] && !level.target[c])
+                return Cell(c);
+        }
+        return kNoCell;
+    };
+
+    size_t best = nodes.size();
+    Cell bestPlayer = kNoCell;
+    SearchTally tally;
+    size_t head = 0;
+    for (; head < nodes.size() && !stop.stop_requested(); head++) {
+        tally.Queue(nodes.size() - head);
+        const PushNode cur = nodes[head];
+        std::vector<uint8_t> grid = Occupancy(cur, level);
+        Cell top;
+        std::vector<uint8_t> reach = ReachableCells(grid, cur.player, H, W, top);
+
+        if (depth[head] > 0 && (best == nodes.size() || depth[head] > depth[best])) {
+            Cell player = startCell(cur, reach);
+            if (player != kNoCell) {
+                best = head;
+                bestPlayer = player;
+            }
+        }
+
+        for (const PushNode& next : GeneratePulls(cur, uint32_t(head), level, grid, reach)) {
+            tally.generated++;
+            if (nodes.size() >= maxNodes)
+                continue;  // бюджет исчерпан: доразбираем уже открытые узлы
+            TableInsert r = visited.Insert(next.hash, uint32_t(nodes.size()));
+            if (r == TableInsert::FOUND)
+                tally.duplicates++;
+            if (r != TableInsert::INSERTED)
+                continue;
+            nodes.push_back(next);
+            depth.push_back(depth[head] + 1);
+        }
+    }
+    tally.expanded = head;
+    tally.peakVisited = visited.Size();
+    tally.Publish();
+    if (best == nodes.size() || stop.stop_requested())
+        return {};  // ни одной тяги — уровень вырожденный
+
+    // толчки вперёд — это тяги в обратном порядке, то есть просто путь к корню
+    std::vector<Directions> pushes;
+    for (size_t i = best; nodes[i].parent != i; i = nodes[i].parent) {
+        pushes.push_back(nodes[i].push);
+    }
+    PushNode far = nodes[best];
+    far.player = bestPlayer;
+    return SolvedState(goal, far, std::move(pushes), level);
+}
+
+// Двунаправленный BFS: вперёд толчками от старта и назад тягами от решённых состояний (ящики на
+// целях, игрок в каждой своей области). Состояния обеих сторон сравниваются по одному ключу —
+// ящики и левая верхняя клетка области игрока, — поэтому встреча ищется в таблице другой стороны.
+// За шаг раскрывается целый слой той стороны, чей фронт меньше; ребёнок сразу проверяется по
+// всей таблице встречной стороны. Лучшая встреча в слое, где нашлась первая, оптимальна: любой
+// более короткий путь встретился бы ещё в прошлом слое. Каждая сторона уходит примерно на d/2.
+// Решение — толчки от старта до встречи и дальше по обратному дереву до корня (там записаны
+// толчки, отменяющие тяги). Стороны делят memBytes пополам; таблица заполнилась — поиск сдаётся.
+StateForGenerator BidirectionalBFSGenerated(const StateForGenerator& start, int H, int W, std::stop_token stop, size_t memBytes) {
+    PushLevel level = BuildPushLevel(start, H, W);
+    if (start.reverseMap.boxes.size() != level.targets.size())
+        return {};
+    // обратная сторона стартует из ящиков на целях, а с буквами таких расстановок не одна
+    if (level.lettered)
+        return BFSGenerated(start, H, W, stop, memBytes);
+    for (const auto& b : start.reverseMap.boxes) {
+        if (!InBounds(b, H, W) || level.dead[b.y * W + b.x])
+            return {};  // ящик уже стоит в тупике
+    }
+
+    struct Side {
+        std::vector<PushNode> nodes;
+        std::vector<uint16_t> depth;
+        TranspositionTable visited;
+        size_t layerBegin = 0;
+        explicit Side(size_t bytes) : visited(bytes) {}
+        size_t Frontier() const { return nodes.size() - layerBegin; }
+    };
+    const size_t sideTable = SearchTableBytes(memBytes / 2, sizeof(PushNode) + sizeof(uint16_t));
+    Side forward(sideTable);
+    Side backward(sideTable);
+
+    forward.nodes.push_back(MakePushNode(start, level));
+    forward.depth.push_back(0);
+    forward.visited.Insert(forward.nodes[0].hash, 0);
+
+    StateForGenerator goal = start;
+    for (Point b : start.reverseMap.boxes) goal.map.Set(b, BlockType::EMPTY);
+    goal.reverseMap.boxes = level.targets;
+    for (Point t : level.targets) goal.map.Set(t, BlockType::BOX);
+    for (const PushNode& source : PullSources(MakePushNode(goal, level), level)) {
+        backward.visited.Insert(source.hash, uint32_t(backward.nodes.size()));
+        backward.nodes.push_back(source);
+        backward.depth.push_back(0);
+    }
+
+    // лучшая встреча: номер узла в каждом дереве и суммарная длина
+    uint32_t meetForward = 0;
+    uint32_t meetBackward = 0;
+    int best = std::numeric_limits<int>::max();
+    if (const uint32_t* b = backward.visited.Find(forward.nodes[0].hash)) {
+        meetBackward = *b;
+        best = 0;
+    }
+
+    SearchTally tally;
+    auto publish = [&] {
+        tally.peakVisited = forward.visited.Size() + backward.visited.Size();
+        tally.Publish();
+    };
+
+    while (best == std::numeric_limits<int>::max() && forward.Frontier() > 0 && backward.Frontier() > 0) {
+        if (stop.stop_requested()) {
+            publish();
+            return {};  // поиск отменён
+        }
+        const bool isForward = forward.Frontier() <= backward.Frontier();
+        Side& side = isForward ? forward : backward;
+        Side& other = isForward ? backward : forward;
+        tally.Queue(forward.Frontier() + backward.Frontier());
+
+        const size_t layerEnd = side.nodes.size();
+        for (size_t head = side.layerBegin; head < layerEnd; head++) {
+            tally.expanded++;
+            std::vector<PushNode> children;
+            if (isForward) {
+                children = GenerateNeighbors(side.nodes[head], uint32_t(head), level, tally.deadlocks);
+            } else {
+                std::vector<uint8_t> grid = Occupancy(side.nodes[head], level);
+                Cell top;
+                std::vector<uint8_t> reach = ReachableCells(grid, side.nodes[head].player, H, W, top);
+                children = GeneratePulls(side.nodes[head], uint32_t(head), level, grid, reach);
+            }
+            const int childDepth = side.depth[head] + 1;
+            for (const PushNode& next : children) {
+                tally.generated++;
+                TableInsert r = side.visited.Insert(next.hash, uint32_t(side.nodes.size()));
+                if (r == TableInsert::FOUND) {
+                    tally.duplicates++;
+                    continue;
+                }
+                if (r == TableInsert::FULL) {
+                    tally.gaveUp = true;
+                    publish();
+                    return {};  // память поиска исчерпана
+                }
+                side.nodes.push_back(next);
+                side.depth.push_back(uint16_t(childDepth));
+                if (const uint32_t* o = other.visited.Find(next.hash)) {
+                    int total = childDepth + other.depth[*o];
+                    if (total < best) {
+                        best = total;
+                        meetForward = isForward ? uint32_t(side.nodes.size() - 1) : *o;
+                        meetBackward = isForward ? *o : uint32_t(side.nodes.size() - 1);
+                    }
+                }
+            }
+        }
+        side.layerBegin = layerEnd;
+    }
+    publish();
+    if (best == std::numeric_limits<int>::max())
+        return {};  // одна из сторон исчерпана — решения нет
+
+    // толчки до встречи, затем толчки, отменяющие тяги, от встречи к корню обратного дерева
+    std::vector<Directions> pushes = PushPath(forward.nodes, meetForward);
+    uint32_t i = meetBackward;
+    for (; backward.nodes[i].parent != i; i = backward.nodes[i].parent) pushes.push_back(backward.nodes[i].push);
+    return SolvedState(start, backward.nodes[i], std::move(pushes), level);
+}
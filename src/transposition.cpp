@@ -0,0 +1,35 @@
+#include "../inc/transposition.h"
+
+#include <algorithm>
+#include <bit>
+
+constexpr size_t kInitialCapacity = 256;
+
+TranspositionTable::TranspositionTable(size_t memBytes, TableFullPolicy p) : policy(p) {
+    // ёмкость — степень двойки, не больше бюджета; совсем маленький бюджет округляется до 16 записей
+    maxCapacity = std::bit_floor(std::max<size_t>(memBytes / kEntryBytes, 16));
+    size_t capacity = std::min(kInitialCapacity, maxCapacity);
+    entries = std::make_unique<Entry[]>(capacity);
+    mask = capacity - 1;
+    shift = 64 - std::countr_zero(capacity);
+}
+
+void TranspositionTable::Grow() {
+    const size_t oldCapacity = mask + 1;
+    std::unique_ptr<Entry[]> old = std::move(entries);
+    entries = std::make_unique<Entry[]>(oldCapacity * 2);
+    mask = oldCapacity * 2 - 1;
+    shift--;
+    for (size_t j = 0; j < oldCapacity; j++) {
+        if (old[j].Key() == 0)
+            continue;
+        size_t i = Home(old[j].Key());
+        while (entries[i].Key() != 0) i = (i + 1) & mask;
+        entries[i] = old[j];
+    }
+}
+
+void TranspositionTable::Clear() {
+    std::fill(entries.get(), entries.get() + mask + 1, Entry{});
+    size = 0;
+}
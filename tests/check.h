@@ -0,0 +1,18 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+#include <string>
+
+// Общая проверка тестов: провал печатается в stderr и считается в failures,
+// main теста возвращает failures как код возврата
+inline int failures = 0;
+
+inline void Expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+#endif
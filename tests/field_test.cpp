@@ -0,0 +1,63 @@
+// Проверки журнала ходов Field (запускается через ctest): Undo возвращает клетки, игрока и счёт
+// ящиков на целях, Redo повторяет отменённое, новый ход обрезает ветку Redo, Restart ставит
+// начальное положение и оставляет журнал. Код возврата — число проваленных проверок.
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "../inc/field.h"
+#include "check.h"
+
+int main() {
+    std::stringstream ss(
+        "ooooooo\n"
+        "ox A ao\n"
+        "o     o\n"
+        "ooooooo\n");
+    Field f(ss);
+    auto game = std::make_shared<GameDescriptor>(f);
+    f.SetGame(game);
+    StepAnim anim;
+
+    const std::string start = f.ToString();
+    Expect(!f.Undo(), "field: Undo at the start");
+    Expect(!f.Redo(anim), "field: Redo with an empty journal");
+
+    // шаг без ящика, толчок, толчок на цель
+    Expect(f.Move(Directions::RIGHT, anim), "field: step is refused");
+    const std::string stepped = f.ToString();
+    Expect(f.Move(Directions::RIGHT, anim), "field: push is refused");
+    const std::string pushed = f.ToString();
+    Expect(f.Move(Directions::RIGHT, anim), "field: push onto the goal is refused");
+    const std::string won = f.ToString();
+    Expect(f.HaveWon(*game), "field: box on its goal is not a win");
+    Expect(!f.Move(Directions::RIGHT, anim), "field: box is pushed into the wall");
+
+    Expect(f.Undo() && f.ToString() == pushed, "field: Undo of the push onto the goal");
+    Expect(!f.HaveWon(*game), "field: win is kept after Undo");
+    Expect(f.GetLoaderPosition() == Point{3, 1}, "field: player after Undo");
+    Expect(f.Undo() && f.ToString() == stepped, "field: Undo of the push");
+    Expect(f.Undo() && f.ToString() == start, "field: Undo of the step");
+    Expect(!f.Undo(), "field: Undo past the start");
+
+    Expect(f.Redo(anim) && f.ToString() == stepped, "field: Redo of the step");
+    Expect(f.Redo(anim) && f.Redo(anim) && f.ToString() == won, "field: Redo of the pushes");
+    Expect(f.HaveWon(*game), "field: win is lost after Redo");
+    Expect(!f.Redo(anim), "field: Redo past the end");
+
+    // новый ход после Undo — отменённые ходы больше не повторить
+    Expect(f.Undo() && f.Undo(), "field: Undo before a new move");
+    Expect(f.Move(Directions::DOWN, anim), "field: new move after Undo is refused");
+    Expect(!f.Redo(anim), "field: Redo branch is kept after a new move");
+    Expect(f.Undo() && f.ToString() == stepped, "field: Undo of the new move");
+
+    Expect(f.Redo(anim) && f.Move(Directions::RIGHT, anim), "field: moves before Restart");
+    f.Restart();
+    Expect(f.ToString() == start, "field: Restart does not restore the level");
+    Expect(f.GetLoaderPosition() == Point{1, 1}, "field: player after Restart");
+    Expect(!f.HaveWon(*game) && !f.Undo(), "field: state after Restart");
+    Expect(f.Redo(anim) && f.ToString() == stepped, "field: journal is lost on Restart");
+
+    std::cerr << "field journal: " << failures << " failures" << std::endl;
+    return failures;
+}
@@ -0,0 +1,97 @@
+// Проверки LevelPool на временном файле (запускается через ctest): повторы по CanonicalLevelHash,
+// Draw — каждый уровень один раз за сессию, уровни переживают перезагрузку вместе с решением,
+// повреждённый хвост файла отрезается, и дописанное после этого снова читается.
+// Код возврата — число проваленных проверок.
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../inc/pool.h"
+#include "check.h"
+
+static const GeneratorParams kParams{4, 5, 1, 0, 1};
+
+static PooledLevel MakePooled(const std::string& text, std::vector<Directions> solution) {
+    return PooledLevel{kParams, 0, text, std::move(solution)};
+}
+
+// Все уровни нужных параметров, которые Draw выдаст до nullopt
+static std::vector<PooledLevel> DrawAll(LevelPool& pool) {
+    std::vector<PooledLevel> drawn;
+    while (auto level = pool.Draw(kParams)) drawn.push_back(std::move(*level));
+    return drawn;
+}
+
+int main() {
+    const std::string file = (std::filesystem::temp_directory_path() / "sokoban_test.pool").string();
+    std::filesystem::remove(file);
+
+    const PooledLevel first = MakePooled(
+        "ooooo\n"
+        "ox  o\n"
+        "o Aao\n"
+        "ooooo\n",
+        {Directions::RIGHT});
+    // тот же уровень: игрок в другом месте своей области
+    const PooledLevel moved = MakePooled(
+        "ooooo\n"
+        "o  xo\n"
+        "o Aao\n"
+        "ooooo\n",
+        {Directions::RIGHT});
+    const PooledLevel second = MakePooled(
+        "ooooo\n"
+        "ox  o\n"
+        "oA ao\n"
+        "ooooo\n",
+        {Directions::RIGHT, Directions::RIGHT});
+    const PooledLevel third = MakePooled(
+        "ooooo\n"
+        "oa  o\n"
+        "o A o\n"
+        "ox  o\n",
+        {Directions::UP, Directions::LEFT});
+
+    {
+        LevelPool pool(file);
+        Expect(pool.Size() == 0, "pool: new file is not empty");
+        Expect(pool.Add(first, false), "pool: first level is not added");
+        Expect(!pool.Add(moved, false), "pool: the same level with the player moved is added again");
+        Expect(pool.Add(second, true), "pool: second level is not added");
+        Expect(pool.Size() == 2 && pool.Available(kParams) == 1, "pool: a drawn level is still available");
+        std::vector<PooledLevel> drawn = DrawAll(pool);
+        Expect(drawn.size() == 1 && drawn[0].text == first.text, "pool: Draw does not return the undrawn level once");
+        Expect(pool.Available({9, 9, 1, 0, 1}) == 0 && !pool.Draw({9, 9, 1, 0, 1}), "pool: levels of other parameters");
+    }
+
+    {
+        LevelPool pool(file);
+        Expect(pool.Size() == 2 && pool.Available(kParams) == 2, "pool: levels are lost on reload");
+        std::vector<PooledLevel> drawn = DrawAll(pool);
+        Expect(drawn.size() == 2, "pool: Draw after reload");
+        for (const PooledLevel& level : drawn) {
+            const PooledLevel& added = level.text == first.text ? first : second;
+            Expect(level.text == added.text && level.solution == added.solution && level.params == kParams,
+                   "pool: level differs after reload");
+        }
+    }
+
+    // оборванная запись в конце: при загрузке отрезается, дописанный после неё уровень читается
+    const uintmax_t intact = std::filesystem::file_size(file);
+    std::ofstream(file, std::ios::app) << "level 4 5 1 0 1 1234 2 RR\nooooo\nox  o\n";
+    {
+        LevelPool pool(file);
+        Expect(pool.Size() == 2, "pool: damaged tail changes the loaded levels");
+        Expect(std::filesystem::file_size(file) == intact, "pool: damaged tail is not cut off");
+        Expect(pool.Add(third, false), "pool: level after the cut is not added");
+    }
+    {
+        LevelPool pool(file);
+        Expect(pool.Size() == 3 && pool.Available(kParams) == 3, "pool: level added after the cut is lost");
+    }
+
+    std::filesystem::remove(file);
+    std::cerr << "level pool: " << failures << " failures" << std::endl;
+    return failures;
+}
@@ -0,0 +1,366 @@
+// Проверки поисков и пакетов на корпусе из фиксированного зерна (запускается через ctest).
+// Для каждого уровня:
+//   - BFSGenerated находит столько же толчков, сколько простой BFS без отсечений тупиков,
+//     или, как и он, не находит решения;
+//   - все режимы SolveGenerated и параллельный BFS на нескольких потоках находят решение
+//     той же длины, что и BFSGenerated, или, как и он, не находят;
+//   - решение разворачивается PushesToLurd, и ходы LURD, сыгранные по клеткам, ставят все ящики на цели;
+//   - пакет sokoban-pack читается обратно тем же уровнем, с названием и буквами.
+// Повреждённый пакет не открывается, уровень за концом пакета — out_of_range.
+// Код возврата — число проваленных проверок.
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../inc/levels.h"
+#include "../inc/pack.h"
+#include "../inc/prog.h"
+#include "check.h"
+
+// Уровень как у GenerateAttempt: стены, ящики, игрок и цели из rng. Решаемость не проверяется.
+static std::optional<ParsedLevel> MakeLevel(int H, int W, int boxes, int clusters, std::mt19937& rng, int number) {
+    Map placed = PlaceWalls(H, W, clusters, rng);
+    auto inside = [&](int margin) {
+        return [=](Point p) { return p.x >= margin && p.x <= W - 1 - margin && p.y >= margin && p.y <= H - 1 - margin; };
+    };
+    ReverseMap rev;
+    for (int i = 0; i < boxes; i++) {
+        std::optional<Point> b = placed.RandomFree(rng, inside(2));
+        if (!b)
+            return std::nullopt;
+        placed.Set(*b, BlockType::BOX);
+        rev.boxes.push_back(*b);
+    }
+    std::optional<Point> player = placed.RandomFree(rng, inside(1));
+    if (!player)
+        return std::nullopt;
+    placed.Set(*player, BlockType::PLAYER);
+    rev.player = *player;
+    for (int i = 0; i < boxes; i++) {
+        std::optional<Point> t = placed.RandomFree(rng, inside(1));
+        if (!t)
+            return std::nullopt;
+        placed.Set(*t, BlockType::TARGET);
+        rev.targets.push_back(*t);
+    }
+    placed.Set(rev.player, BlockType::EMPTY);
+    for (const auto& t : rev.targets) placed.Set(t, BlockType::EMPTY);
+
+    ParsedLevel level;
+    level.title = std::to_string(H) + "x" + std::to_string(W) + " #" + std::to_string(number);
+    level.height = H;
+    level.width = W;
+    level.start = {placed, rev, {}};
+    return level;
+}
+
+// Ходы LURD по клеткам: шаг — только на свободную клетку, толчок — только ящика на свободную
+static bool PlaysToWin(const ParsedLevel& level, const std::string& lurd) {
+    const int H = level.height;
+    const int W = level.width;
+    std::vector<uint8_t> box(H * W, 0);
+    for (Point b : level.start.reverseMap.boxes) box[b.y * W + b.x] = 1;
+    auto free = [&](Point p) { return InBounds(p, H, W) && !IsWallType(level.start.map.At(p)) && !box[p.y * W + p.x]; };
+
+    Point player = level.start.reverseMap.player;
+    for (char c : lurd) {
+        const char* dirs = "lrud";
+        const char* found = std::strchr(dirs, std::tolower(static_cast<unsigned char>(c)));
+        if (found == nullptr)
+            return false;
+        static const Point kDelta[] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        const Point d = kDelta[found - dirs];
+        const Point next = player + d;
+        const bool push = std::isupper(static_cast<unsigned char>(c));
+        if (push) {
+            if (!InBounds(next, H, W) || !box[next.y * W + next.x] || !free(next + d))
+                return false;
+            box[next.y * W + next.x] = 0;
+            box[(next + d).y * W + (next + d).x] = 1;
+        } else if (!free(next)) {
+            return false;
+        }
+        player = next;
+    }
+    for (Point t : level.start.reverseMap.targets)
+        if (!box[t.y * W + t.x])
+            return false;
+    return true;
+}
+
+static std::vector<Point> Sorted(std::vector<Point> points) {
+    std::sort(points.begin(), points.end(), [](Point a, Point b) { return a.y != b.y ? a.y < b.y : a.x < b.x; });
+    return points;
+}
+
+// Буквы по клеткам: сначала H * W клеток ящиков, потом H * W клеток целей; ' ' — без буквы
+static std::string LetterGrid(const ParsedLevel& level) {
+    const ReverseMap& rev = level.start.reverseMap;
+    const int cells = level.height * level.width;
+    std::string grid(2 * cells, ' ');
+    for (size_t i = 0; i < rev.boxLetters.size(); i++)
+        grid[rev.boxes[i].y * level.width + rev.boxes[i].x] = rev.boxLetters[i] ? rev.boxLetters[i] : ' ';
+    for (size_t i = 0; i < rev.targetLetters.size(); i++)
+        grid[cells + rev.targets[i].y * level.width + rev.targets[i].x] = rev.targetLetters[i] ? rev.targetLetters[i] : ' ';
+    return grid;
+}
+
+static bool SameLevel(const ParsedLevel& a, const ParsedLevel& b) {
+    if (a.title != b.title || a.height != b.height || a.width != b.width ||
+        !(a.start.reverseMap.player == b.start.reverseMap.player) ||
+        Sorted(a.start.reverseMap.boxes) != Sorted(b.start.reverseMap.boxes) ||
+        Sorted(a.start.reverseMap.targets) != Sorted(b.start.reverseMap.targets) || LetterGrid(a) != LetterGrid(b))
+        return false;
+    for (int y = 0; y < a.height; y++)
+        for (int x = 0; x < a.width; x++)
+            if (IsWallType(a.start.map.At({x, y})) != IsWallType(b.start.map.At({x, y})))
+                return false;
+    return true;
+}
+
+// Эталон без отсечений: BFS по толчкам без простых тупиков, замораживания и загонов. Состояние —
+// буквы ящиков по клеткам ('$' — ящик без буквы) и верхняя левая клетка, куда дойдёт игрок.
+// Возвращает число толчков или -1, если решения нет.
+static int UnprunedPushes(const ParsedLevel& level) {
+    const int H = level.height;
+    const int W = level.width;
+    const ReverseMap& rev = level.start.reverseMap;
+    if (rev.boxes.size() != rev.targets.size())
+        return -1;
+    auto open = [&](Point p) { return InBounds(p, H, W) && !IsWallType(level.start.map.At(p)); };
+    static const Point kDelta[] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+    std::string start(H * W, ' ');
+    for (size_t i = 0; i < rev.boxes.size(); i++)
+        start[rev.boxes[i].y * W + rev.boxes[i].x] = i < rev.boxLetters.size() && rev.boxLetters[i] ? rev.boxLetters[i] : '$';
+    auto solved = [&](const std::string& boxes) {
+        for (size_t i = 0; i < rev.targets.size(); i++) {
+            const char on = boxes[rev.targets[i].y * W + rev.targets[i].x];
+            const char letter = i < rev.targetLetters.size() ? rev.targetLetters[i] : 0;
+            if (on == ' ' || (letter && on != letter))
+                return false;
+        }
+        return true;
+    };
+    // клетки, куда игрок доходит без толчков; первая в списке — верхняя левая
+    auto reach = [&](const std::string& boxes, Point player) {
+        std::vector<uint8_t> seen(H * W, 0);
+        std::vector<Point> cells{player};
+        seen[player.y * W + player.x] = 1;
+        for (size_t i = 0; i < cells.size(); i++) {
+            for (Point d : kDelta) {
+                const Point n = cells[i] + d;
+                if (open(n) && boxes[n.y * W + n.x] == ' ' && !seen[n.y * W + n.x]) {
+                    seen[n.y * W + n.x] = 1;
+                    cells.push_back(n);
+                }
+            }
+        }
+        std::sort(cells.begin(), cells.end(), [](Point a, Point b) { return a.y != b.y ? a.y < b.y : a.x < b.x; });
+        return cells;
+    };
+
+    std::unordered_set<std::string> visited;
+    std::queue<std::pair<std::string, Point>> layer;
+    auto visit = [&](const std::string& boxes, Point player) {
+        const Point corner = reach(boxes, player).front();
+        if (visited.insert(boxes + char(corner.y) + char(corner.x)).second)
+            layer.emplace(boxes, player);
+    };
+    visit(start, rev.player);
+    for (int pushes = 0; !layer.empty(); pushes++) {
+        for (size_t n = layer.size(); n > 0; n--) {
+            const auto [boxes, player] = layer.front();
+            layer.pop();
+            if (solved(boxes))
+                return pushes;
+            for (Point cell : reach(boxes, player)) {
+                for (Point d : kDelta) {
+                    const Point box = cell + d;
+                    const Point dest = box + d;
+                    if (!open(box) || boxes[box.y * W + box.x] == ' ' || !open(dest) || boxes[dest.y * W + dest.x] != ' ')
+                        continue;
+                    std::string next = boxes;
+                    next[dest.y * W + dest.x] = next[box.y * W + box.x];
+                    next[box.y * W + box.x] = ' ';
+                    visit(next, box);
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+static void CheckSearches(const ParsedLevel& level, int& solvable) {
+    const int H = level.height;
+    const int W = level.width;
+    const StateForGenerator bfs = BFSGenerated(level.start, H, W);
+    const bool won = HaveWonMap(bfs);
+    solvable += won;
+
+    const int oracle = UnprunedPushes(level);
+    Expect((oracle >= 0) == won, level.title + ": BFSGenerated solvable differs from the unpruned BFS");
+    if (won && oracle >= 0)
+        Expect(int(bfs.movesHistory.size()) == oracle, level.title + ": BFSGenerated " + std::to_string(bfs.movesHistory.size()) +
+                                                           " pushes, unpruned BFS " + std::to_string(oracle));
+
+    struct Mode {
+        const char* name;
+        SolverMode mode;
+    };
+    const Mode modes[] = {{"astar", SolverMode::ASTAR},        {"idastar", SolverMode::IDASTAR},
+                          {"auto", SolverMode::AUTO},          {"parallel", SolverMode::PARALLEL_BFS},
+                          {"reverse", SolverMode::REVERSE},    {"bidir", SolverMode::BIDIRECTIONAL},
+                          {"bfs", SolverMode::BFS}};
+    std::vector<std::pair<std::string, StateForGenerator>> results;
+    for (const Mode& m : modes) results.emplace_back(m.name, SolveGenerated(level.start, H, W, m.mode));
+    // на одном ядре PARALLEL_BFS идёт без потоков — здесь слои точно режутся на куски
+    results.emplace_back("parallel x4", ParallelBFSGenerated(level.start, H, W, 4));
+
+    for (const auto& [name, solved] : results) {
+        const std::string what = level.title + " " + name;
+        Expect(HaveWonMap(solved) == won, what + ": solvable differs from BFSGenerated");
+        if (!won || !HaveWonMap(solved))
+            continue;
+        Expect(solved.movesHistory.size() == bfs.movesHistory.size(),
+               what + ": " + std::to_string(solved.movesHistory.size()) + " pushes, BFSGenerated " +
+                   std::to_string(bfs.movesHistory.size()));
+        std::optional<std::string> lurd = PushesToLurd(level, solved.movesHistory);
+        Expect(lurd.has_value(), what + ": pushes do not replay");
+        if (lurd) {
+            auto push = [](char c) { return std::isupper(static_cast<unsigned char>(c)) != 0; };
+            const size_t pushes = size_t(std::count_if(lurd->begin(), lurd->end(), push));
+            Expect(pushes == solved.movesHistory.size(), what + ": LURD push count");
+            Expect(PlaysToWin(level, *lurd), what + ": LURD does not solve the level");
+        }
+    }
+}
+
+static void CheckPack(const std::vector<ParsedLevel>& levels) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    const std::string good = (dir / "sokoban_test.pack").string();
+    const std::string bad = (dir / "sokoban_test_bad.pack").string();
+
+    WriteLevelPack(good, levels);
+    Expect(IsLevelPack(good), "pack: magic");
+    {
+        LevelPack pack(good);
+        Expect(pack.Size() == levels.size(), "pack: level count");
+        for (size_t i = 0; i < pack.Size() && i < levels.size(); i++)
+            Expect(SameLevel(pack[i].ToParsed(), levels[i]), "pack: level " + std::to_string(i) + " differs after reading back");
+        bool outOfRange = false;
+        try {
+            pack[pack.Size()];
+        } catch (const std::out_of_range&) {
+            outOfRange = true;
+        }
+        Expect(outOfRange, "pack: level past the end is not out_of_range");
+
+        // поле игры берёт буквы из пакета, а не раздаёт их заново по порядку строк
+        for (size_t i = 0; i < pack.Size(); i++) {
+            if (pack[i].GetTitle() != "swap")
+                continue;
+            Field f = pack[i].ToField();
+            Expect(f.GetCell({3, 2}) == 'A' && f.GetCell({3, 3}) == 'B' && f.GetCell({5, 2}) == 'b' && f.GetCell({5, 3}) == 'a',
+                   "pack: swap letters differ in the game field");
+        }
+    }
+
+    std::ifstream in(good, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    auto rejects = [&](const std::string& content, const std::string& what) {
+        std::ofstream(bad, std::ios::binary | std::ios::trunc) << content;
+        bool thrown = false;
+        try {
+            LevelPack pack(bad);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        Expect(thrown, "pack: " + what + " is opened");
+    };
+    rejects(bytes.substr(0, bytes.size() / 2), "truncated pack");
+
+    // первое смещение индекса указывает далеко за конец файла
+    PackHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    std::string farOffset = bytes;
+    const uint64_t far = uint64_t(1) << 40;
+    std::memcpy(&farOffset[header.indexOffset], &far, sizeof(far));
+    rejects(farOffset, "pack with an offset past the end");
+
+    // запись объявляет размер больше, чем есть места до индекса
+    std::string tall = bytes;
+    uint64_t last;
+    std::memcpy(&last, &bytes[header.indexOffset + (header.count - 1) * sizeof(uint64_t)], sizeof(last));
+    tall[last] = char(200);
+    rejects(tall, "pack with an oversized record");
+
+    std::filesystem::remove(good);
+    std::filesystem::remove(bad);
+}
+
+int main() {
+    struct Set {
+        int H, W, boxes, clusters, count;
+    };
+    const Set sets[] = {{8, 8, 2, 10, 10}, {10, 10, 2, 20, 8}, {10, 10, 3, 20, 6}};
+    std::mt19937 rng(20240601u);
+    std::vector<ParsedLevel> corpus;
+    for (const Set& set : sets) {
+        int made = 0;
+        for (int tries = 0; made < set.count && tries < 1000; tries++) {
+            if (auto level = MakeLevel(set.H, set.W, set.boxes, set.clusters, rng, made)) {
+                corpus.push_back(std::move(*level));
+                made++;
+            }
+        }
+    }
+
+    // к случайным картам — XSB, где все режимы должны сойтись на «решения нет»: ящик в углу,
+    // и карта игры с буквами: ящики надо поменять местами, без букв хватило бы двух толчков
+    std::istringstream xsb(
+        "; corner\n"
+        "######\n"
+        "#$  .#\n"
+        "#  @ #\n"
+        "######\n"
+        "; two boxes\n"
+        "#######\n"
+        "#.  $ #\n"
+        "# @$ .#\n"
+        "#     #\n"
+        "#######\n"
+        "; swap\n"
+        "oooooooo\n"
+        "o      o\n"
+        "o xA b o\n"
+        "o  B a o\n"
+        "o      o\n"
+        "oooooooo\n");
+    for (ParsedLevel& level : ReadLevelCollection(xsb)) corpus.push_back(std::move(level));
+    Expect(corpus.size() > 3 && corpus[corpus.size() - 3].title == "corner", "XSB levels are not read");
+    const ParsedLevel& swap = corpus.back();
+    Expect(swap.title == "swap" && swap.start.reverseMap.boxLetters == std::vector<char>{'a', 'b'} &&
+               swap.start.reverseMap.targetLetters == std::vector<char>{'b', 'a'},
+           "swap: letters are not read");
+    const StateForGenerator swapped = BFSGenerated(swap.start, swap.height, swap.width);
+    Expect(HaveWonMap(swapped) && swapped.movesHistory.size() > 2, "swap: letters are ignored by the search");
+
+    int solvable = 0;
+    for (const ParsedLevel& level : corpus) CheckSearches(level, solvable);
+    Expect(solvable > 0 && solvable < int(corpus.size()), "corpus needs both solvable and unsolvable levels");
+    CheckPack(corpus);
+
+    std::cerr << corpus.size() << " levels, " << solvable << " solvable, " << failures << " failures" << std::endl;
+    return failures;
+}
@@ -0,0 +1,86 @@
+// Проверки TranspositionTable (запускается через ctest): рост до бюджета, обе политики
+// заполненной таблицы, ключ 0 и Clear. Код возврата — число проваленных проверок.
+#include <string>
+
+#include "../inc/transposition.h"
+#include "check.h"
+
+// Разные ненулевые ключи, разбросанные по ячейкам: умножение на нечётное число взаимно однозначно
+static uint64_t Key(uint64_t i) {
+    return (i + 2) * 0xD6E8FEB86659FD93ull;
+}
+
+static void CheckGrowth() {
+    TranspositionTable table;
+    const uint32_t n = 100000;
+    for (uint32_t i = 0; i < n; i++) Expect(table.Insert(Key(i), i) == TableInsert::INSERTED, "growth: insert " + std::to_string(i));
+    Expect(table.Size() == n, "growth: size");
+    Expect(table.Size() * 4 <= table.Capacity() * 3, "growth: filled past 3/4");
+    bool all = true;
+    for (uint32_t i = 0; i < n; i++) {
+        const uint32_t* v = table.Find(Key(i));
+        all &= v != nullptr && *v == i;
+    }
+    Expect(all, "growth: a key is lost after growing");
+    Expect(table.Insert(Key(7), 123) == TableInsert::FOUND && *table.Find(Key(7)) == 7, "growth: FOUND changes the value");
+}
+
+// Бюджет на 16 записей: ключей помещается 12, дальше FULL, а известные ключи по-прежнему находятся
+static void CheckGiveUp() {
+    TranspositionTable table(16 * TranspositionTable::kEntryBytes);
+    for (uint32_t i = 0; i < 12; i++) Expect(table.Insert(Key(i), i) == TableInsert::INSERTED, "give up: insert " + std::to_string(i));
+    uint32_t unset = 0;
+    uint32_t* slot = &unset;
+    Expect(table.Insert(Key(12), 12, &slot) == TableInsert::FULL && slot == nullptr, "give up: 13th key is not FULL");
+    Expect(table.Size() == 12 && table.Capacity() == 16, "give up: table grew past its budget");
+    Expect(table.Find(Key(12)) == nullptr, "give up: rejected key is found");
+    Expect(table.Insert(Key(3), 0, &slot) == TableInsert::FOUND && *slot == 3, "give up: known key is not FOUND when full");
+    table.Clear();
+    Expect(table.Size() == 0 && table.Find(Key(3)) == nullptr, "give up: Clear keeps keys");
+    Expect(table.Insert(Key(12), 12) == TableInsert::INSERTED, "give up: no room after Clear");
+}
+
+// Кэш на 16 записей: заполненный, он затирает занятые домашние ячейки и не трогает пустые,
+// поэтому свежий ключ находится, а пустые ячейки (и конец пробирования) не пропадают
+static void CheckReplace() {
+    TranspositionTable table(16 * TranspositionTable::kEntryBytes, TableFullPolicy::REPLACE);
+    size_t replaced = 0;
+    size_t dropped = 0;
+    bool fresh = true;
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint32_t* slot = nullptr;
+        const TableInsert r = table.Insert(Key(i), i, &slot);
+        const uint32_t* v = table.Find(Key(i));
+        if (r == TableInsert::INSERTED) {
+            replaced += i >= 12;
+            fresh &= slot != nullptr && *slot == i && v != nullptr && *v == i;
+        } else {
+            dropped++;
+            fresh &= r == TableInsert::FULL && slot == nullptr && v == nullptr;
+        }
+    }
+    Expect(fresh, "replace: a stored key is not found or a dropped one is");
+    Expect(replaced > 0 && dropped > 0, "replace: full cache neither replaces nor drops");
+    Expect(table.Size() == 12 && table.Capacity() == 16, "replace: size or capacity past the budget");
+    Expect(table.Find(Key(5000)) == nullptr, "replace: lookup of a missing key");
+}
+
+// Ключ 0 занят под пустую ячейку и хранится как 1 — он должен находиться, а не теряться
+static void CheckZeroKey() {
+    TranspositionTable table;
+    Expect(table.Find(0) == nullptr, "zero key: found in an empty table");
+    Expect(table.Insert(0, 42) == TableInsert::INSERTED, "zero key: not inserted");
+    const uint32_t* v = table.Find(0);
+    Expect(v != nullptr && *v == 42, "zero key: not found after insert");
+    Expect(table.Insert(0, 7) == TableInsert::FOUND && *table.Find(0) == 42, "zero key: inserted twice");
+    Expect(table.Size() == 1, "zero key: size");
+}
+
+int main() {
+    CheckGrowth();
+    CheckGiveUp();
+    CheckReplace();
+    CheckZeroKey();
+    std::cerr << "transposition table: " << failures << " failures" << std::endl;
+    return failures;
+}